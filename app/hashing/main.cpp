@@ -1,5 +1,7 @@
 #include "tracing/hash_trace.h"
+#include "tracing/hit_counters.h"
 #include "tracing/printer.h"
+#include "tracing/span.h"
 #include "tracing/trace.h"
 
 #include <iostream>
@@ -16,6 +18,10 @@ int main(int argc, char* argv[])
   Printer printer;
   printer.registerOutput(writeOutput);
 
+  // Decoders check every block of 8 records and pick the dictionary of this build
+  printer.registerSyncInterval(8);
+  printer.printHeader("hashing");
+
   /*
    * Simple printer
    */
@@ -55,5 +61,35 @@ int main(int argc, char* argv[])
   constexpr auto hashError = HashTrace::error("Byczy {:#b} Byk {}");
   printer.print(hashError, 0x7890, 0xB);
 
+  printer.print(HashTrace::info<int16_t, bool, const char*>("Byczy {} Byk {} {}"), -10, true, "Muczy");
+
+  printer.print(HashTrace::warning<"Byczy {} Byk bez tekstu">(), 12);
+  printer.print(HashTrace::error<"Byczy {} Byk {}", uint8_t, bool>(), 0xFF, false);
+
+  printer.print("");
+
+  /*
+   * Duration spans
+   */
+  printer.print("# Duration spans #");
+
+  {
+    Span pasture(printer, HashTrace::span("Pastwisko {}"), 3);
+    Span milking(printer, HashTrace::span<"Dojenie">());
+    printer.print(HashTrace::info("Muu"));
+  }
+
+  printer.print("");
+
+  /*
+   * Hit counters
+   */
+  printer.print("# Hit counters #");
+
+  for (int i = 0; i < 5; i++) {
+    HitCounters::hit<HashTrace::info<"Krowa przeszla przez bramke">()>();
+  }
+  HitCounters::dump(writeOutput);
+
   return 0;
 }
@@ -0,0 +1,76 @@
+#ifndef APP_LOADGEN_LATENCY_HISTOGRAM_H
+#define APP_LOADGEN_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Log-linear histogram, every power of two is split into SubBuckets linear
+ * buckets, so percentiles keep about 1.5% precision at any magnitude with a
+ * fixed 32 KiB per producer thread.
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr unsigned int SubBucketBits = 6;
+  static constexpr uint64_t SubBuckets = 1U << SubBucketBits;
+  static constexpr size_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+public:
+  void add(uint64_t value)
+  {
+    m_buckets[index(value)]++;
+    m_count++;
+  }
+
+  void merge(const LatencyHistogram& other)
+  {
+    for (size_t i = 0; i < BucketCount; i++) {
+      m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+  }
+
+  uint64_t count() const { return m_count; }
+
+  // Upper bound of the bucket holding the given fraction of all values
+  uint64_t percentile(double fraction) const
+  {
+    const uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(m_count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BucketCount; i++) {
+      seen += m_buckets[i];
+      if (seen > rank) {
+        return upperBound(i);
+      }
+    }
+    return m_count ? upperBound(BucketCount - 1) : 0;
+  }
+
+private:
+  static size_t index(uint64_t value)
+  {
+    if (value < SubBuckets) {
+      return value;
+    }
+    const unsigned int shift = std::bit_width(value) - SubBucketBits - 1;
+    return ((shift + 1) * SubBuckets) + ((value >> shift) - SubBuckets);
+  }
+
+  static uint64_t upperBound(size_t index)
+  {
+    if (index < SubBuckets) {
+      return index;
+    }
+    const unsigned int shift = (index / SubBuckets) - 1;
+    return ((SubBuckets + (index % SubBuckets) + 1) << shift) - 1;
+  }
+
+private:
+  std::array<uint64_t, BucketCount> m_buckets{};
+  uint64_t m_count = 0;
+};
+
+#endif /* APP_LOADGEN_LATENCY_HISTOGRAM_H */
@@ -0,0 +1,368 @@
+#include "latency_histogram.h"
+
+#include "tracing/archive.h"
+#include "tracing/fanout.h"
+#include "tracing/hash_trace.h"
+#include "tracing/metrics.h"
+#include "tracing/printer.h"
+#include "tracing/trace.h"
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace tracing;
+
+/*
+ * Load generator: N producer threads print a mix of record kinds at a fixed
+ * rate into one sink type and report sustained records/s, print() latency
+ * percentiles and drops. The library is single-producer per printer, so
+ * every thread owns its printer, as an application would.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Kind
+{
+  Plain,
+  Trace,
+  Hash,
+  Typed,
+};
+
+enum class Sink
+{
+  Printer,
+  Archive,
+  Fanout,
+};
+
+struct Options
+{
+  unsigned int threads = 4;
+  uint64_t rate = 0;
+  double duration = 2.0;
+  unsigned int maxArguments = 3;
+  std::vector<Kind> mix = { Kind::Plain, Kind::Trace, Kind::Hash, Kind::Typed };
+  std::vector<Sink> sinks = { Sink::Printer, Sink::Archive, Sink::Fanout };
+};
+
+struct Result
+{
+  uint64_t records = 0;
+  uint64_t drops = 0;
+  uint64_t bytes = 0;
+  LatencyHistogram latency;
+};
+
+std::atomic<uint64_t> OutputBytes{ 0 };
+thread_local uint64_t ThreadOutputBytes = 0;
+
+void countCharacter(const char)
+{
+  ThreadOutputBytes++;
+}
+
+void countBytes(const uint8_t*, size_t size)
+{
+  ThreadOutputBytes += size;
+}
+
+void countSharedBytes(const uint8_t*, size_t size)
+{
+  OutputBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+const char* sinkName(Sink sink)
+{
+  switch (sink) {
+    case Sink::Printer:
+      return "printer";
+    case Sink::Archive:
+      return "archive";
+    default:
+      return "fanout";
+  }
+}
+
+template<typename PrinterType>
+void emit(PrinterType& printer, Kind kind, unsigned int arguments, uint64_t sequence)
+{
+  const uint32_t value = static_cast<uint32_t>(sequence);
+  switch (kind) {
+    case Kind::Plain:
+      switch (arguments) {
+        case 0:
+          return printer.print("I:Load plain record");
+        case 1:
+          return printer.print("I:Load plain record {}", value);
+        case 2:
+          return printer.print("I:Load plain record {} {:#x}", value, sequence);
+        default:
+          return printer.print("I:Load plain record {} {:#x} {}", value, sequence, "text");
+      }
+    case Kind::Trace:
+      if constexpr (std::is_same_v<PrinterType, ArchivePrinter>) {
+        // The archive takes hashed IDs only, plain Trace text is interned like runtime strings
+        return emit(printer, Kind::Plain, arguments, sequence);
+      } else {
+        switch (arguments) {
+          case 0:
+            return printer.print(Trace::warning("Load trace record"));
+          case 1:
+            return printer.print(Trace::warning("Load trace record {}"), value);
+          case 2:
+            return printer.print(Trace::warning("Load trace record {} {:#x}"), value, sequence);
+          default:
+            return printer.print(Trace::warning("Load trace record {} {:#x} {}"), value, sequence, "text");
+        }
+      }
+    case Kind::Hash:
+      switch (arguments) {
+        case 0:
+          return printer.print(HashTrace::info<"Load hashed record">());
+        case 1:
+          return printer.print(HashTrace::info<"Load hashed record {}">(), value);
+        case 2:
+          return printer.print(HashTrace::info<"Load hashed record {} {}">(), value, sequence);
+        default:
+          return printer.print(HashTrace::info<"Load hashed record {} {} {}">(), value, sequence, "text");
+      }
+    case Kind::Typed:
+      switch (arguments) {
+        case 0:
+        case 1:
+          return printer.print(HashTrace::error<"Load typed record {}", uint32_t>(), value);
+        case 2:
+          return printer.print(HashTrace::error<"Load typed record {} {}", uint32_t, double>(), value, 0.5 * value);
+        default:
+          return printer.print(HashTrace::error<"Load typed record {} {} {}", uint32_t, double, const char*>(), value, 0.5 * value, "text");
+      }
+  }
+}
+
+template<typename PrinterType>
+void produce(PrinterType& printer, const Options& options, const std::atomic<bool>& running, double cyclesPerNs, Result& result)
+{
+  const auto start = Clock::now();
+  uint64_t sequence = 0;
+  while (running.load(std::memory_order_relaxed)) {
+    if (options.rate) {
+      const auto due = start + std::chrono::nanoseconds(sequence * 1000000000 / options.rate);
+      while (Clock::now() < due) {
+        if (!running.load(std::memory_order_relaxed)) {
+          return;
+        }
+      }
+    }
+
+    const Kind kind = options.mix[sequence % options.mix.size()];
+    const unsigned int arguments = (sequence / options.mix.size()) % (options.maxArguments + 1);
+
+    const uint64_t begin = Metrics::cycles();
+    emit(printer, kind, arguments, sequence);
+    const uint64_t end = Metrics::cycles();
+
+    result.latency.add(static_cast<uint64_t>(static_cast<double>(end - begin) / cyclesPerNs));
+    result.records++;
+    sequence++;
+  }
+}
+
+uint64_t totalDrops(const Metrics& metrics)
+{
+  return metrics.snapshot().drops;
+}
+
+void runThread(Sink sink, const Options& options, const std::atomic<bool>& running, double cyclesPerNs, Result& result)
+{
+  ThreadOutputBytes = 0;
+  Metrics metrics;
+
+  switch (sink) {
+    case Sink::Printer: {
+      Printer printer;
+      printer.registerOutput(countCharacter);
+      printer.registerMetrics(&metrics);
+      produce(printer, options, running, cyclesPerNs, result);
+      result.drops = totalDrops(metrics);
+      break;
+    }
+    case Sink::Archive: {
+      auto printer = std::make_unique<ArchivePrinter>();
+      printer->registerOutput(countBytes);
+      printer->registerMetrics(&metrics);
+      printer->open();
+      produce(*printer, options, running, cyclesPerNs, result);
+      printer->close();
+      result.drops = totalDrops(metrics);
+      break;
+    }
+    case Sink::Fanout: {
+      // Everything as ANSI text plus a binary flight recorder, both drop when their writer falls behind
+      FanoutPrinter printer;
+      printer.addSink({ .write = countSharedBytes });
+      printer.addSink({ .write = countSharedBytes, .format = FanoutPrinter::Format::Binary });
+      printer.start();
+      printer.open();
+      produce(printer, options, running, cyclesPerNs, result);
+      printer.close();
+      printer.stop();
+      result.drops = printer.drops(0) + printer.drops(1);
+      break;
+    }
+  }
+  result.bytes = ThreadOutputBytes;
+}
+
+double calibrateCycles()
+{
+  const auto start = Clock::now();
+  const uint64_t begin = Metrics::cycles();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  const uint64_t end = Metrics::cycles();
+  const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  return static_cast<double>(end - begin) / elapsed;
+}
+
+void report(Sink sink, const Options& options, const std::vector<Result>& results, double seconds)
+{
+  Result total;
+  for (const auto& result : results) {
+    total.records += result.records;
+    total.drops += result.drops;
+    total.bytes += result.bytes;
+    total.latency.merge(result.latency);
+  }
+  total.bytes += OutputBytes.exchange(0);
+
+  std::printf("%-8s threads %u  records %llu  records/s %.0f  MB/s %.1f  p50 %llu ns  p99 %llu ns  p999 %llu ns  drops %llu\n",
+              sinkName(sink),
+              options.threads,
+              static_cast<unsigned long long>(total.records),
+              static_cast<double>(total.records) / seconds,
+              static_cast<double>(total.bytes) / seconds / 1e6,
+              static_cast<unsigned long long>(total.latency.percentile(0.5)),
+              static_cast<unsigned long long>(total.latency.percentile(0.99)),
+              static_cast<unsigned long long>(total.latency.percentile(0.999)),
+              static_cast<unsigned long long>(total.drops));
+}
+
+template<typename T>
+bool parseNumber(std::string_view text, T& value)
+{
+  const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+  return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool parseList(std::string_view text, auto parse, auto& output)
+{
+  output.clear();
+  while (!text.empty()) {
+    const size_t comma = text.find(',');
+    if (!parse(text.substr(0, comma), output)) {
+      return false;
+    }
+    text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+  }
+  return !output.empty();
+}
+
+bool parseKind(std::string_view name, std::vector<Kind>& mix)
+{
+  constexpr std::pair<std::string_view, Kind> kinds[] = {
+    { "plain", Kind::Plain }, { "trace", Kind::Trace }, { "hash", Kind::Hash }, { "typed", Kind::Typed }
+  };
+  for (const auto& [kindName, kind] : kinds) {
+    if (name == kindName) {
+      mix.push_back(kind);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseSink(std::string_view name, std::vector<Sink>& sinks)
+{
+  for (Sink sink : { Sink::Printer, Sink::Archive, Sink::Fanout }) {
+    if (name == sinkName(sink)) {
+      sinks.push_back(sink);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++) {
+    const std::string_view option = argv[i];
+    if (i + 1 == argc) {
+      return false;
+    }
+    const std::string_view value = argv[++i];
+
+    bool valid = false;
+    if (option == "--threads") {
+      valid = parseNumber(value, options.threads) && options.threads > 0;
+    } else if (option == "--rate") {
+      valid = parseNumber(value, options.rate);
+    } else if (option == "--duration") {
+      valid = parseNumber(value, options.duration) && options.duration > 0;
+    } else if (option == "--arguments") {
+      valid = parseNumber(value, options.maxArguments) && options.maxArguments <= 3;
+    } else if (option == "--mix") {
+      valid = parseList(value, parseKind, options.mix);
+    } else if (option == "--sinks") {
+      valid = parseList(value, parseSink, options.sinks);
+    }
+    if (!valid) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    std::fprintf(stderr,
+                 "usage: %s [--threads N] [--rate records/s per thread, 0 = unlimited] [--duration seconds]\n"
+                 "          [--arguments 0-3] [--mix plain,trace,hash,typed] [--sinks printer,archive,fanout]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  const double cyclesPerNs = calibrateCycles();
+
+  for (Sink sink : options.sinks) {
+    std::atomic<bool> running{ true };
+    std::vector<Result> results(options.threads);
+    std::vector<std::thread> threads;
+
+    const auto start = Clock::now();
+    for (unsigned int i = 0; i < options.threads; i++) {
+      threads.emplace_back(runThread, sink, std::cref(options), std::cref(running), cyclesPerNs, std::ref(results[i]));
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+    running.store(false, std::memory_order_relaxed);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    report(sink, options, results, seconds);
+  }
+
+  return 0;
+}
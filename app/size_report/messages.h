@@ -0,0 +1,26 @@
+#ifndef APP_SIZE_REPORT_MESSAGES_H
+#define APP_SIZE_REPORT_MESSAGES_H
+
+/*
+ * The same set of messages is traced by both size report apps. Every
+ * HashTrace ID takes 33 bytes, so only texts longer than that are saved.
+ */
+#define SIZE_REPORT_MESSAGES(TRACE)                                           \
+  TRACE("Silnik {} uruchomiony, oczekiwanie na stabilizacje obrotow")         \
+  TRACE("Silnik {} zatrzymany po {} obrotach z powodu przeciazenia")          \
+  TRACE("Czujnik temperatury {} zwrocil odczyt {} poza zakresem pracy")       \
+  TRACE("Czujnik cisnienia {} nie odpowiada, ponawianie zapytania")           \
+  TRACE("Magistrala {:#x} zajeta przez inne urzadzenie, transfer wstrzymany") \
+  TRACE("Magistrala {:#x} zwolniona, wznawianie oczekujacych transferow")     \
+  TRACE("Bufor odbiorczy przepelniony, utracono {} bajtow danych")            \
+  TRACE("Bufor nadawczy pusty, wylaczanie przerwania nadajnika")              \
+  TRACE("Zegar systemowy przestrojony, nowa czestotliwosc {} Hz")             \
+  TRACE("Watchdog odswiezony po {} ms od poprzedniego odswiezenia")           \
+  TRACE("Przerwanie {} zgloszone podczas obslugi innego przerwania")          \
+  TRACE("Przerwanie {} obsluzone w {} us, przekroczono budzet czasu")         \
+  TRACE("Konfiguracja {} zapisana w pamieci nieulotnej")                      \
+  TRACE("Konfiguracja {} odczytana z bledem {}, uzyto wartosci domyslnych")   \
+  TRACE("Napiecie zasilania {} mV ponizej progu, ograniczanie poboru mocy")   \
+  TRACE("Napiecie zasilania przywrocone, powrot do normalnej pracy")
+
+#endif /* APP_SIZE_REPORT_MESSAGES_H */
@@ -0,0 +1,36 @@
+# Prints section sizes of the Trace and HashTrace size report apps.
+#
+# cmake -DSIZE_TOOL=<size> -DTRACE=<app> -DHASH_TRACE=<app> -P size_report.cmake
+
+function(get_section_size file section output)
+  execute_process(
+    COMMAND ${SIZE_TOOL} -A -d ${file}
+    OUTPUT_VARIABLE sections
+    COMMAND_ERROR_IS_FATAL ANY
+  )
+  string(REPLACE "." "\\." pattern "${section}")
+  if(sections MATCHES "\n${pattern}[ ]+([0-9]+)")
+    set(${output} ${CMAKE_MATCH_1} PARENT_SCOPE)
+  else()
+    set(${output} 0 PARENT_SCOPE)
+  endif()
+endfunction()
+
+function(print_row)
+  set(row "")
+  foreach(column ${ARGN})
+    string(LENGTH "${column}" length)
+    math(EXPR length "12 - ${length}")
+    string(REPEAT " " ${length} padding)
+    string(APPEND row "${column}${padding}")
+  endforeach()
+  message("${row}")
+endfunction()
+
+print_row(section Trace HashTrace saving)
+foreach(section .rodata .text)
+  get_section_size(${TRACE} ${section} trace)
+  get_section_size(${HASH_TRACE} ${section} hashTrace)
+  math(EXPR saving "${trace} - ${hashTrace}")
+  print_row(${section} ${trace} ${hashTrace} ${saving})
+endforeach()
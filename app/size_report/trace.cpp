@@ -0,0 +1,24 @@
+#include "messages.h"
+#include "tracing/printer.h"
+#include "tracing/trace.h"
+
+#include <cstdio>
+
+using namespace tracing;
+
+void writeOutput(const char character)
+{
+  std::putchar(character);
+}
+
+#define PRINT_TRACE(text) printer.print(Trace::info(text), argc);
+
+int main(int argc, char* argv[])
+{
+  Printer printer;
+  printer.registerOutput(writeOutput);
+
+  SIZE_REPORT_MESSAGES(PRINT_TRACE)
+
+  return 0;
+}
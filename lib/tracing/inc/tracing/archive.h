@@ -0,0 +1,340 @@
+#ifndef LIB_TRACING_ARCHIVE_H
+#define LIB_TRACING_ARCHIVE_H
+
+#include "tracing/hashing.h"
+#include "tracing/intern.h"
+#include "tracing/metrics.h"
+#include "tracing/signature.h"
+
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace tracing {
+
+/*
+ * Indexed, chunked on-disk trace archive.
+ *
+ * File layout (all integers little-endian):
+ *   FileHeader
+ *   Chunk 0 .. Chunk N-1
+ *   GlobalIndex (one IndexEntry per chunk)
+ *   Trailer
+ *
+ * Every chunk is at most ChunkSize bytes and is built from a ChunkHeader,
+ * binary records and a ChunkFooter holding the chunk time range, a bloom
+ * filter over trace IDs and per-ID record counts. Readers map the file,
+ * read the Trailer and GlobalIndex and skip every chunk which cannot match.
+ *
+ * Runtime (non-literal) strings are interned: a Definition record maps the
+ * runtime ID to the text once per chunk, so every chunk decodes on its own.
+ * A full intern table is cleared, its texts get new IDs and definitions.
+ */
+class ArchivePrinter
+{
+public:
+  using OutputFunction = void (*)(const uint8_t* data, size_t size);
+  using TimestampFunction = uint64_t (*)();
+  using TraceId = Md5Hash;
+
+  static constexpr uint32_t FileMagic = 0x41525448;   // "HTRA"
+  static constexpr uint32_t ChunkMagic = 0x4B435448;  // "HTCK"
+  static constexpr uint32_t TrailerMagic = 0x58495448; // "HTIX"
+  static constexpr uint16_t FormatVersion = 1;
+
+  static constexpr size_t ChunkSize = 64 * 1024;
+  static constexpr size_t FileHeaderSize = 16;
+  static constexpr size_t ChunkHeaderSize = 16;
+  static constexpr size_t IndexEntrySize = 32;
+  static constexpr size_t TrailerSize = 16;
+  static constexpr size_t BloomFilterBits = 2048;
+  static constexpr size_t BloomFilterHashes = 4;
+  static constexpr size_t MaxChunkIds = 256;
+  static constexpr size_t IdCountEntrySize = Md5HashLen + sizeof(uint32_t);
+  static constexpr size_t MaxArguments = 16;
+  static constexpr size_t MaxStringSize = 1024;
+
+  enum RecordKind : uint8_t
+  {
+    Trace = 1,
+    Typed = 2,
+    Definition = 3,
+    Interned = 4,
+  };
+
+  enum ArgumentType : uint8_t
+  {
+    Bool = 1,
+    Signed = 2,
+    Unsigned = 3,
+    String = 4,
+    Float = 5,
+    Pointer = 6,
+    Bytes = 7,
+  };
+
+public:
+  ArchivePrinter();
+
+  void registerOutput(OutputFunction out);
+  void registerTimestamp(TimestampFunction timestamp);
+  void registerMetrics(Metrics* metrics);
+
+  void open();
+  void flush();
+  void close();
+
+  template<size_t size, typename... Args>
+  void print(const std::array<unsigned char, size> text, Args... arguments);
+
+  template<char level, typename... Args>
+  void print(const HashId<level>& id, Args... arguments);
+
+  template<char level, typename... Types, typename... Args>
+  void print(const TypedTrace<level, Types...>& trace, Args... arguments);
+
+  template<typename... Args>
+  void print(const char* text, Args... arguments);
+
+private:
+  static constexpr size_t RecordPrefixSize = 2 + sizeof(uint64_t);
+  static constexpr size_t RecordHeaderSize = RecordPrefixSize + Md5HashLen;
+  static constexpr size_t InternedHeaderSize = RecordPrefixSize + sizeof(uint32_t);
+  static constexpr size_t FooterFixedSize = 2 * sizeof(uint64_t) + (BloomFilterBits / 8) + sizeof(uint32_t);
+  static constexpr size_t MaxFooterSize = FooterFixedSize + (MaxChunkIds * IdCountEntrySize);
+  static constexpr size_t ChunkDataSize = ChunkSize - ChunkHeaderSize - MaxFooterSize;
+
+  struct IdCount
+  {
+    TraceId id;
+    uint32_t count;
+  };
+
+  struct IndexEntry
+  {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t records;
+    uint64_t begin;
+    uint64_t end;
+  };
+
+private:
+  static TraceId parseId(const unsigned char* text);
+  uint32_t internId(const char* text);
+
+  template<size_t size, typename... Args>
+  void printTrace(Metrics::Level level, const std::array<unsigned char, size>& text, Args... arguments);
+
+  template<typename Arg>
+  static constexpr size_t valueSize(Arg argument);
+  template<typename Arg>
+  static constexpr uint8_t argumentType();
+  template<typename Arg>
+  static constexpr auto widen(Arg argument);
+  template<typename Arg>
+  void encodeValue(Arg argument);
+
+  bool reserve(size_t size);
+  bool reserve(size_t size, const TraceId& id);
+  void drop();
+  void beginRecord(RecordKind kind, size_t arguments);
+  void beginTrace(RecordKind kind, Metrics::Level level, const TraceId& id, size_t arguments, size_t size);
+  void beginInterned(uint32_t id, const char* text, size_t arguments, size_t size);
+  void countId(const TraceId& id);
+  void putBytes(const void* data, size_t size);
+  template<typename T>
+  void putValue(T value);
+  void write(const uint8_t* data, size_t size);
+
+private:
+  OutputFunction m_out;
+  TimestampFunction m_timestamp;
+  Metrics* m_metrics;
+  uint64_t m_offset;
+  bool m_open;
+
+  std::array<uint8_t, ChunkDataSize> m_data;
+  size_t m_used;
+  uint32_t m_records;
+  uint64_t m_begin;
+  uint64_t m_end;
+  std::array<uint8_t, BloomFilterBits / 8> m_bloom;
+  std::array<IdCount, MaxChunkIds> m_ids;
+  size_t m_idCount;
+  std::bitset<InternTable::Capacity + 1> m_defined;
+
+  InternTable m_intern;
+  std::vector<IndexEntry> m_index;
+};
+
+template<size_t size, typename... Args>
+void ArchivePrinter::print(const std::array<unsigned char, size> text, Args... arguments)
+{
+  printTrace(Metrics::Level::Other, text, arguments...);
+}
+
+template<char level, typename... Args>
+void ArchivePrinter::print(const HashId<level>& id, Args... arguments)
+{
+  printTrace(Metrics::level(level), id, arguments...);
+}
+
+template<size_t size, typename... Args>
+void ArchivePrinter::printTrace(Metrics::Level level, const std::array<unsigned char, size>& text, Args... arguments)
+{
+  static_assert(size == (Md5HashLen * 2) + 1, "Archive accepts HashTrace IDs only");
+  static_assert(sizeof...(Args) <= MaxArguments, "Too many arguments");
+
+  if (!m_open || text.back() != 0) {
+    drop();
+    return;
+  }
+
+  const auto id = parseId(text.data());
+  const size_t recordSize = RecordHeaderSize + ((1 + valueSize(widen(arguments))) + ... + 0);
+  if (!reserve(recordSize, id)) {
+    return;
+  }
+
+  beginTrace(RecordKind::Trace, level, id, sizeof...(Args), recordSize);
+  ((putValue(argumentType<Args>()), encodeValue(widen(arguments))), ...);
+}
+
+template<char level, typename... Types, typename... Args>
+void ArchivePrinter::print(const TypedTrace<level, Types...>& trace, Args... arguments)
+{
+  static_assert(TypedTrace<level, Types...>::template matches<Args...>(), "Trace arguments do not match the declared signature");
+  static_assert(sizeof...(Args) <= MaxArguments, "Too many arguments");
+
+  if (!m_open || !TypedTrace<level, Types...>::fits(arguments...)) {
+    drop();
+    return;
+  }
+
+  const auto id = parseId(trace.id.data());
+  const size_t recordSize = RecordHeaderSize + (valueSize(static_cast<Types>(arguments)) + ... + 0);
+  if (!reserve(recordSize, id)) {
+    return;
+  }
+
+  beginTrace(RecordKind::Typed, Metrics::level(level), id, sizeof...(Args), recordSize);
+  (encodeValue(static_cast<Types>(arguments)), ...);
+}
+
+template<typename... Args>
+void ArchivePrinter::print(const char* text, Args... arguments)
+{
+  static_assert(sizeof...(Args) <= MaxArguments, "Too many arguments");
+
+  if (!m_open || !text) {
+    drop();
+    return;
+  }
+
+  const uint32_t id = internId(text);
+  const size_t definitionSize = RecordPrefixSize + sizeof(uint32_t) + valueSize(text);
+  const size_t recordSize = InternedHeaderSize + ((1 + valueSize(widen(arguments))) + ... + 0);
+  if (!reserve(definitionSize + recordSize)) {
+    return;
+  }
+
+  beginInterned(id, text, sizeof...(Args), recordSize);
+  ((putValue(argumentType<Args>()), encodeValue(widen(arguments))), ...);
+}
+
+template<typename Arg>
+constexpr size_t ArchivePrinter::valueSize(Arg argument)
+{
+  if constexpr (std::is_arithmetic_v<Arg>) {
+    return sizeof(Arg);
+  } else if constexpr (isDataPointer<Arg>) {
+    return sizeof(uint64_t);
+  } else if constexpr (isCharPointer<Arg>) {
+    const size_t length = argument ? std::strlen(argument) : 0;
+    return sizeof(uint16_t) + (length < MaxStringSize ? length : MaxStringSize);
+  } else {
+    static_assert(std::is_same_v<Arg, std::string_view> || isByteSpan<Arg>, "Unsupported argument type");
+    return sizeof(uint16_t) + (argument.size() < MaxStringSize ? argument.size() : MaxStringSize);
+  }
+}
+
+/*
+ * Untyped records carry a type tag per argument and widen integers to 64
+ * bits and floating point to double. Pointers are 64-bit addresses, string
+ * views and byte blobs are stored like strings, with their known length.
+ */
+template<typename Arg>
+constexpr uint8_t ArchivePrinter::argumentType()
+{
+  if constexpr (std::is_same_v<Arg, bool>) {
+    return ArgumentType::Bool;
+  } else if constexpr (std::is_integral_v<Arg> && std::is_signed_v<Arg>) {
+    return ArgumentType::Signed;
+  } else if constexpr (std::is_integral_v<Arg>) {
+    return ArgumentType::Unsigned;
+  } else if constexpr (std::is_floating_point_v<Arg>) {
+    return ArgumentType::Float;
+  } else if constexpr (isDataPointer<Arg>) {
+    return ArgumentType::Pointer;
+  } else if constexpr (isByteSpan<Arg>) {
+    return ArgumentType::Bytes;
+  } else {
+    return ArgumentType::String;
+  }
+}
+
+template<typename Arg>
+constexpr auto ArchivePrinter::widen(Arg argument)
+{
+  if constexpr (std::is_same_v<Arg, bool> || !std::is_arithmetic_v<Arg>) {
+    return argument;
+  } else if constexpr (std::is_floating_point_v<Arg>) {
+    return static_cast<double>(argument);
+  } else if constexpr (std::is_signed_v<Arg>) {
+    return static_cast<int64_t>(argument);
+  } else {
+    return static_cast<uint64_t>(argument);
+  }
+}
+
+template<typename Arg>
+void ArchivePrinter::encodeValue(Arg argument)
+{
+  if constexpr (std::is_same_v<Arg, bool>) {
+    putValue<uint8_t>(argument ? 1 : 0);
+  } else if constexpr (std::is_integral_v<Arg>) {
+    putValue<Arg>(argument);
+  } else if constexpr (std::is_same_v<Arg, float>) {
+    putValue(std::bit_cast<uint32_t>(argument));
+  } else if constexpr (std::is_same_v<Arg, double>) {
+    putValue(std::bit_cast<uint64_t>(argument));
+  } else if constexpr (isDataPointer<Arg>) {
+    putValue<uint64_t>(reinterpret_cast<uintptr_t>(argument));
+  } else if constexpr (isCharPointer<Arg>) {
+    const size_t length = argument ? std::strlen(argument) : 0;
+    const uint16_t stored = length < MaxStringSize ? length : MaxStringSize;
+    putValue<uint16_t>(stored);
+    putBytes(argument, stored);
+  } else {
+    const uint16_t stored = argument.size() < MaxStringSize ? argument.size() : MaxStringSize;
+    putValue<uint16_t>(stored);
+    putBytes(argument.data(), stored);
+  }
+}
+
+template<typename T>
+void ArchivePrinter::putValue(T value)
+{
+  for (unsigned int i = 0; i < sizeof(T); i++) {
+    m_data[m_used++] = static_cast<uint8_t>(value >> (i * 8));
+  }
+}
+
+}
+
+#endif /* LIB_TRACING_ARCHIVE_H */
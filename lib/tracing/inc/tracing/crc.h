@@ -0,0 +1,55 @@
+#ifndef LIB_TRACING_CRC_H
+#define LIB_TRACING_CRC_H
+
+#include <array>
+#include <cstdint>
+
+namespace tracing {
+
+constexpr uint32_t Crc32Polynomial = 0xEDB88320;
+
+// Four bits per step, 64 bytes of table keep small targets small
+constexpr std::array<uint32_t, 16> makeCrc32Table()
+{
+  std::array<uint32_t, 16> table{};
+  for (uint32_t i = 0; i < table.size(); i++) {
+    uint32_t value = i;
+    for (unsigned int bit = 0; bit < 4; bit++) {
+      value = (value & 1) ? (Crc32Polynomial ^ (value >> 1)) : (value >> 1);
+    }
+    table[i] = value;
+  }
+  return table;
+}
+
+inline constexpr std::array<uint32_t, 16> Crc32Table = makeCrc32Table();
+
+/*
+ * CRC-32 (IEEE 802.3, the zlib.crc32() one), updated one character at a
+ * time as the printer writes them. The running state is kept inverted,
+ * value() gives the finished CRC.
+ */
+class Crc32
+{
+public:
+  constexpr void reset() { m_state = InitialState; }
+
+  constexpr void update(char character)
+  {
+    const uint8_t byte = static_cast<uint8_t>(character);
+    m_state = Crc32Table[(m_state ^ byte) & 0xF] ^ (m_state >> 4);
+    m_state = Crc32Table[(m_state ^ (byte >> 4)) & 0xF] ^ (m_state >> 4);
+  }
+
+  constexpr uint32_t value() const { return ~m_state; }
+
+private:
+  static constexpr uint32_t InitialState = 0xFFFFFFFF;
+
+private:
+  uint32_t m_state = InitialState;
+};
+
+}
+
+#endif /* LIB_TRACING_CRC_H */
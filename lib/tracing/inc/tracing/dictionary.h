@@ -0,0 +1,109 @@
+#ifndef LIB_TRACING_DICTIONARY_H
+#define LIB_TRACING_DICTIONARY_H
+
+#include "tracing/hashing.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace tracing {
+
+struct DictionaryEntry
+{
+  const char* id;
+  const char* text;
+  const char* signature;
+};
+
+/*
+ * Trace dictionary compiled into the program, emitted by
+ * "hash_map_gen.py --cpp" as constexpr tables. IDs are placed with the
+ * same minimal perfect hash as trace.tdict (scripts/binary_dictionary.py):
+ * the first ID half picks a bucket, the bucket holds either a direct slot
+ * or a seed which hashes the second half into the slot.
+ */
+class Dictionary
+{
+public:
+  static constexpr uint32_t DirectSlot = 0x80000000;
+  static constexpr size_t IdSize = Md5HashLen * 2;
+
+public:
+  template<size_t buckets, size_t entries>
+  constexpr Dictionary(const std::array<uint32_t, buckets>& bucketTable, const std::array<DictionaryEntry, entries>& entryTable)
+    : m_buckets(bucketTable.data())
+    , m_bucketCount(buckets)
+    , m_entries(entryTable.data())
+    , m_entryCount(entries)
+  {
+  }
+
+  constexpr size_t size() const { return m_entryCount; }
+
+  // ID as 32 hex characters, the printed form of HashTrace IDs
+  constexpr const DictionaryEntry* find(const char* id) const { return lookup(id); }
+
+  template<size_t size>
+  constexpr const DictionaryEntry* find(const std::array<unsigned char, size>& id) const
+  {
+    static_assert(size == IdSize + 1, "Dictionary IDs are HashTrace IDs");
+    return lookup(id.data());
+  }
+
+  static constexpr uint64_t slotHash(uint64_t key, uint32_t seed)
+  {
+    uint64_t x = key ^ (seed * 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 31)) * 0xBF58476D1CE4E5B9ULL;
+    return x ^ (x >> 29);
+  }
+
+private:
+  template<typename Char>
+  constexpr const DictionaryEntry* lookup(const Char* id) const
+  {
+    uint64_t high = 0;
+    uint64_t low = 0;
+    if (m_entryCount == 0 || !parseHalf(id, high) || !parseHalf(id + (IdSize / 2), low)) {
+      return nullptr;
+    }
+
+    const uint32_t value = m_buckets[high % m_bucketCount];
+    const size_t slot = (value & DirectSlot) ? (value & ~DirectSlot) : (slotHash(low, value) % m_entryCount);
+    const DictionaryEntry& entry = m_entries[slot];
+    for (size_t i = 0; i < IdSize; i++) {
+      if (entry.id[i] != static_cast<char>(id[i])) {
+        return nullptr;
+      }
+    }
+    return &entry;
+  }
+
+  template<typename Char>
+  static constexpr bool parseHalf(const Char* text, uint64_t& value)
+  {
+    for (size_t i = 0; i < IdSize / 2; i++) {
+      const char character = text[i];
+      uint64_t digit = 0;
+      if (character >= '0' && character <= '9') {
+        digit = character - '0';
+      } else if (character >= 'a' && character <= 'f') {
+        digit = character - 'a' + 10;
+      } else {
+        return false;
+      }
+      value = (value << 4) | digit;
+    }
+    return true;
+  }
+
+private:
+  const uint32_t* m_buckets;
+  size_t m_bucketCount;
+  const DictionaryEntry* m_entries;
+  size_t m_entryCount;
+};
+
+}
+
+#endif /* LIB_TRACING_DICTIONARY_H */
@@ -0,0 +1,205 @@
+#ifndef LIB_TRACING_FANOUT_H
+#define LIB_TRACING_FANOUT_H
+
+#include "tracing/archive.h"
+#include "tracing/metrics.h"
+#include "tracing/printer.h"
+#include "tracing/signature.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tracing {
+
+/*
+ * Delivers every record to several sinks, each with its own minimum level,
+ * format and full-buffer policy.
+ *
+ * Text records are formatted once with ANSI colors, plain sinks get the same
+ * record with the escapes stripped. Records no ANSI sink takes are formatted
+ * with the plain printer profile instead. Binary sinks get the trace archive
+ * stream; every binary sink encodes its own archive, as chunk footers and
+ * the index describe one stream. Every sink has its own bounded buffer and,
+ * after start(), its own writer thread, so a slow sink only loses its own
+ * records (or, with Policy::Block, stalls the producer alone). Text records
+ * longer than MaxRecordSize are dropped whole and counted in drops().
+ *
+ * Levels follow Metrics::level(), HashTrace IDs carry theirs in the HashId
+ * type. Span IDs and plain ID arrays have none, they reach only sinks which
+ * take everything (Level::Info).
+ *
+ * Like Printer, a FanoutPrinter has a single producer thread.
+ */
+class FanoutPrinter
+{
+public:
+  using WriteFunction = void (*)(const uint8_t* data, size_t size);
+
+  enum class Format : uint8_t
+  {
+    Ansi,
+    Plain,
+    Binary,
+  };
+
+  enum class Policy : uint8_t
+  {
+    DropNewest,
+    DropOldest,
+    Block,
+  };
+
+  // Binary sinks buffer whole archive chunks, their capacity is at least two chunks
+  struct SinkConfig
+  {
+    WriteFunction write = nullptr;
+    Metrics::Level level = Metrics::Level::Info;
+    Format format = Format::Ansi;
+    Policy policy = Policy::DropNewest;
+    size_t capacity = 64 * 1024;
+  };
+
+  static constexpr size_t MaxSinks = 8;
+  static constexpr size_t MaxRecordSize = 1024;
+
+public:
+  FanoutPrinter();
+  ~FanoutPrinter();
+
+  FanoutPrinter(const FanoutPrinter&) = delete;
+  FanoutPrinter& operator=(const FanoutPrinter&) = delete;
+
+  // Sinks are added before open() and start()
+  bool addSink(const SinkConfig& config);
+  void registerTimestamp(ArchivePrinter::TimestampFunction timestamp);
+
+  void open();
+  void close();
+
+  // Writer threads, without them records wait for drain() on the producer thread
+  void start();
+  void stop();
+  void drain();
+
+  uint64_t drops(size_t sink) const;
+
+  template<typename... Args>
+  void print(const char* text, Args... arguments);
+
+  template<typename T, size_t size, typename... Args>
+  void print(const std::array<T, size> text, Args... arguments);
+
+  template<char level, typename... Args>
+  void print(const HashId<level>& id, Args... arguments);
+
+  template<char level, typename... Types, typename... Args>
+  void print(const TypedTrace<level, Types...>& trace, Args... arguments);
+
+private:
+  static constexpr size_t FrameHeaderSize = sizeof(uint32_t);
+  static constexpr size_t MinBinaryCapacity =
+    (2 * (ArchivePrinter::ChunkSize + FrameHeaderSize)) + ArchivePrinter::FileHeaderSize + FrameHeaderSize;
+
+  struct Sink
+  {
+    SinkConfig config;
+    std::vector<uint8_t> ring;
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    uint64_t drops = 0;
+    // A dropped chunk moves later offsets, the archive index is left out then
+    bool brokenIndex = false;
+    std::unique_ptr<ArchivePrinter> archive;
+    std::vector<uint8_t> frame;
+
+    mutable std::mutex mutex;
+    std::condition_variable written;
+    std::condition_variable read;
+    std::thread writer;
+    bool running = false;
+  };
+
+private:
+  template<typename Text, typename Binary, typename... Args>
+  void dispatch(Metrics::Level level, const Text& text, const Binary& binary, Args... arguments);
+
+  static bool accepts(const Sink& sink, Metrics::Level level);
+  static void capture(const char character);
+  static void stage(const uint8_t* data, size_t size);
+
+  bool beginText(Metrics::Level level);
+  void endText(Metrics::Level level);
+  void beginBinary();
+  void endBinary(Sink& sink);
+
+  void push(Sink& sink, const uint8_t* data, size_t size);
+  bool pop(Sink& sink);
+  void drain(Sink& sink);
+  void run(Sink& sink);
+
+private:
+  std::vector<std::unique_ptr<Sink>> m_sinks;
+  Printer m_printer;
+  std::array<char, MaxRecordSize> m_record;
+  size_t m_recordSize;
+  bool m_recordAnsi;
+  std::array<char, MaxRecordSize> m_plain;
+  std::vector<uint8_t> m_staging;
+};
+
+template<typename... Args>
+void FanoutPrinter::print(const char* text, Args... arguments)
+{
+  dispatch(Metrics::level(text), text, text, arguments...);
+}
+
+template<typename T, size_t size, typename... Args>
+void FanoutPrinter::print(const std::array<T, size> text, Args... arguments)
+{
+  const char* data = reinterpret_cast<const char*>(text.data());
+  if constexpr (size == (Md5HashLen * 2) + 1) {
+    dispatch(Metrics::Level::Other, text, text, arguments...);
+  } else {
+    // Plain Trace text is interned by the archive
+    dispatch(Metrics::level(data), text, data, arguments...);
+  }
+}
+
+template<char level, typename... Args>
+void FanoutPrinter::print(const HashId<level>& id, Args... arguments)
+{
+  dispatch(Metrics::level(level), id, id, arguments...);
+}
+
+template<char level, typename... Types, typename... Args>
+void FanoutPrinter::print(const TypedTrace<level, Types...>& trace, Args... arguments)
+{
+  dispatch(Metrics::level(level), trace, trace, arguments...);
+}
+
+template<typename Text, typename Binary, typename... Args>
+void FanoutPrinter::dispatch(Metrics::Level level, const Text& text, const Binary& binary, Args... arguments)
+{
+  if (beginText(level)) {
+    m_printer.print(text, arguments...);
+    endText(level);
+  }
+
+  for (auto& sink : m_sinks) {
+    if (sink->archive && accepts(*sink, level)) {
+      beginBinary();
+      sink->archive->print(binary, arguments...);
+      endBinary(*sink);
+    }
+  }
+}
+
+}
+
+#endif /* LIB_TRACING_FANOUT_H */
@@ -0,0 +1,26 @@
+#ifndef LIB_TRACING_FIXED_STRING_H
+#define LIB_TRACING_FIXED_STRING_H
+
+#include <cstddef>
+
+namespace tracing {
+
+/*
+ * String literal usable as a template argument, e.g. HashTrace::info<"text">().
+ */
+template<size_t size>
+struct FixedString
+{
+  constexpr FixedString(const char (&text)[size])
+  {
+    for (size_t i = 0; i < size; i++) {
+      data[i] = text[i];
+    }
+  }
+
+  char data[size]{};
+};
+
+}
+
+#endif /* LIB_TRACING_FIXED_STRING_H */
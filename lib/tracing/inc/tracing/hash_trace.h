@@ -1,7 +1,10 @@
 #ifndef LIB_TRACING_HASH_TRACE_H
 #define LIB_TRACING_HASH_TRACE_H
 
+#include "tracing/fixed_string.h"
 #include "tracing/hashing.h"
+#include "tracing/signature.h"
+#include "tracing/span.h"
 
 #include <array>
 #include <cstdint>
@@ -38,49 +41,112 @@ private:
     return output;
   }
 
-public:
-  template<size_t size>
-  static constexpr std::array<unsigned char, HashTraceSize> info(const char (&text)[size])
+  /*
+   * Hashed text is "<level>:<text>", typed traces fold the argument type
+   * signature in as "<level>:<text>\0<signature>".
+   */
+  template<char level, typename... Types, size_t size>
+  static constexpr auto trace(const char (&text)[size])
   {
-    std::array<unsigned char, (size + HashTrace::LevelMarkSize - 1)> info{};
-    info[0] = 'I';
-    info[1] = ':';
+    constexpr auto signature = typeSignature<Types...>();
+    constexpr size_t signatureSize = signature.empty() ? 0 : signature.size() + 1;
+    std::array<unsigned char, (size + HashTrace::LevelMarkSize - 1 + signatureSize)> data{};
+    data[0] = level;
+    data[1] = ':';
 
     for (unsigned int i = 0; i < (size - 1); i++) {
-      info[i + LevelMarkSize] = text[i];
+      data[i + LevelMarkSize] = text[i];
+    }
+    for (unsigned int i = 0; i < signature.size(); i++) {
+      data[i + LevelMarkSize + size] = signature[i];
     }
 
-    return hashing(info);
+    if constexpr (sizeof...(Types) == 0) {
+      return HashId<level>{ hashing(data) };
+    } else {
+      return TypedTrace<level, Types...>{ HashId<level>{ hashing(data) } };
+    }
   }
 
+public:
   template<size_t size>
-  static constexpr std::array<unsigned char, HashTraceSize> warning(const char (&text)[size])
+  static constexpr HashId<'I'> info(const char (&text)[size])
   {
-    std::array<unsigned char, size + HashTrace::LevelMarkSize - 1> warning{};
-    warning[0] = 'W';
-    warning[1] = ':';
-
-    for (unsigned int i = 0; i < (size - 1); i++) {
-      warning[i + LevelMarkSize] = text[i];
-    }
+    return trace<'I'>(text);
+  }
 
-    return hashing(warning);
+  template<size_t size>
+  static constexpr HashId<'W'> warning(const char (&text)[size])
+  {
+    return trace<'W'>(text);
   }
 
   template<size_t size>
-  static constexpr std::array<unsigned char, HashTraceSize> error(const char (&text)[size])
+  static constexpr HashId<'E'> error(const char (&text)[size])
   {
-    std::array<unsigned char, size + HashTrace::LevelMarkSize - 1> error{};
-    error[0] = 'E';
-    error[1] = ':';
+    return trace<'E'>(text);
+  }
 
-    for (unsigned int i = 0; i < (size - 1); i++) {
-      error[i + LevelMarkSize] = text[i];
-    }
+  template<typename Type, typename... Types, size_t size>
+  static constexpr TypedTrace<'I', Type, Types...> info(const char (&text)[size])
+  {
+    return trace<'I', Type, Types...>(text);
+  }
 
-    return hashing(error);
+  template<typename Type, typename... Types, size_t size>
+  static constexpr TypedTrace<'W', Type, Types...> warning(const char (&text)[size])
+  {
+    return trace<'W', Type, Types...>(text);
+  }
+
+  template<typename Type, typename... Types, size_t size>
+  static constexpr TypedTrace<'E', Type, Types...> error(const char (&text)[size])
+  {
+    return trace<'E', Type, Types...>(text);
+  }
+
+  /*
+   * Template argument form, always evaluated at compile time so the text
+   * never reaches the object file, only its ID does.
+   */
+  template<FixedString text, typename... Types>
+  static consteval auto info()
+  {
+    return trace<'I', Types...>(text.data);
+  }
+
+  template<FixedString text, typename... Types>
+  static consteval auto warning()
+  {
+    return trace<'W', Types...>(text.data);
+  }
+
+  template<FixedString text, typename... Types>
+  static consteval auto error()
+  {
+    return trace<'E', Types...>(text.data);
+  }
+
+  /*
+   * Duration spans, see tracing::Span. Arguments are not typed, the first
+   * two are always the timestamp and the thread ID.
+   */
+  template<size_t size>
+  static constexpr SpanTrace span(const char (&text)[size])
+  {
+    return { trace<'B'>(text), trace<'F'>(text) };
+  }
+
+  template<FixedString text>
+  static consteval SpanTrace span()
+  {
+    return { trace<'B'>(text.data), trace<'F'>(text.data) };
   }
 };
 
+static_assert(HashTrace::info<"a">() == HashTrace::info("a"));
+static_assert(HashTrace::error<"a {}", bool>().id == HashTrace::error<bool>("a {}").id);
+static_assert(HashTrace::span<"a">().end == HashTrace::span("a").end);
+
 }
 #endif /* LIB_TRACING_HASH_TRACE_H */
@@ -0,0 +1,106 @@
+#ifndef LIB_TRACING_HIT_COUNTERS_H
+#define LIB_TRACING_HIT_COUNTERS_H
+
+#include "tracing/hashing.h"
+#include "tracing/signature.h"
+#include "tracing/span.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tracing {
+
+/*
+ * Counter mode, trace sites are counted instead of printed:
+ *
+ *   HitCounters::hit<HashTrace::info<"Cache miss">()>();
+ *
+ * Every site gets its slot on the first hit. Each thread increments its own
+ * cache line aligned row, so the hot path is a plain load and store without
+ * sharing. Rows and the site table are allocated by the first hit, programs
+ * which never count keep only the row pointers. dump() sums the rows and
+ * writes "%<id> <count>" lines, in hex like hashed traces, for the decoder
+ * to map through the dictionary.
+ */
+class HitCounters
+{
+public:
+  using OutputFunction = void (*)(const char);
+
+  static constexpr size_t MaxSites = 1024;
+  static constexpr size_t MaxThreads = 64;
+  static constexpr char CountMark = '%';
+
+public:
+  template<auto trace>
+  static void hit();
+
+  static void dump(OutputFunction out);
+  static uint32_t sites();
+  static uint64_t count(uint32_t site);
+
+private:
+  static constexpr size_t CacheLineSize = 64;
+  static constexpr uint32_t InvalidSite = UINT32_MAX;
+
+  struct alignas(CacheLineSize) Row
+  {
+    std::array<std::atomic<uint64_t>, MaxSites> counts;
+  };
+
+private:
+  template<auto trace>
+  static constexpr const unsigned char* traceId();
+
+  static std::array<std::atomic<const unsigned char*>, MaxSites>& siteIds();
+  static uint32_t registerSite(const unsigned char* id);
+  static Row* threadRow();
+  static Row* acquireRow();
+  static Row& sharedRow();
+
+private:
+  static std::atomic<uint32_t> s_sites;
+  static std::array<std::atomic<Row*>, MaxThreads> s_rows;
+  static std::atomic<uint32_t> s_threads;
+};
+
+template<auto trace>
+void HitCounters::hit()
+{
+  static const uint32_t site = registerSite(traceId<trace>());
+  if (site == InvalidSite) {
+    return;
+  }
+
+  Row* row = threadRow();
+  if (row) {
+    // Only the owning thread writes its row, readers may see a slightly old value
+    auto& counter = row->counts[site];
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  } else {
+    sharedRow().counts[site].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/*
+ * Template parameter objects live for the whole program, their IDs are kept
+ * by pointer.
+ */
+template<auto trace>
+constexpr const unsigned char* HitCounters::traceId()
+{
+  if constexpr (std::is_same_v<decltype(trace), const SpanTrace>) {
+    return trace.begin.data();
+  } else if constexpr (requires { trace.id; }) {
+    return trace.id.data();
+  } else {
+    static_assert(trace.size() == (Md5HashLen * 2) + 1, "Hit counters accept HashTrace IDs only");
+    return trace.data();
+  }
+}
+
+}
+
+#endif /* LIB_TRACING_HIT_COUNTERS_H */
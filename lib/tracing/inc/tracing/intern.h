@@ -0,0 +1,70 @@
+#ifndef LIB_TRACING_INTERN_H
+#define LIB_TRACING_INTERN_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tracing {
+
+/*
+ * Lock-free cache assigning runtime IDs to non-literal trace strings.
+ *
+ * Entries are keyed by content: a slot keeps the hash and its own copy of
+ * the text, so the same message rebuilt in another buffer keeps its ID and a
+ * reused buffer holding a new text gets a new one. Slots are claimed with a
+ * single CAS; when two threads race on the same new text both may get an
+ * ID, which only costs one extra definition record.
+ *
+ * clear() frees every entry and starts IDs over, the next print of a text
+ * defines it again. It must not run concurrently with intern().
+ */
+class InternTable
+{
+public:
+  static constexpr size_t Capacity = 1024;
+  static constexpr uint32_t InvalidId = 0;
+
+  struct Entry
+  {
+    uint32_t id;
+    bool inserted;
+  };
+
+public:
+  constexpr InternTable()
+    : m_slots{}
+    , m_nextId(InvalidId + 1)
+  {
+  }
+  ~InternTable();
+
+  InternTable(const InternTable&) = delete;
+  InternTable& operator=(const InternTable&) = delete;
+
+  Entry intern(const char* text);
+  void clear();
+  uint32_t size() const;
+
+  static uint64_t contentHash(const char* text);
+
+private:
+  static constexpr uint32_t BusyId = UINT32_MAX;
+  static constexpr size_t MaxProbes = 32;
+
+  struct Slot
+  {
+    std::atomic<uint32_t> id;
+    uint64_t hash;
+    char* text;
+  };
+
+private:
+  std::array<Slot, Capacity> m_slots;
+  std::atomic<uint32_t> m_nextId;
+};
+
+}
+
+#endif /* LIB_TRACING_INTERN_H */
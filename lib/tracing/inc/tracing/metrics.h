@@ -0,0 +1,125 @@
+#ifndef LIB_TRACING_METRICS_H
+#define LIB_TRACING_METRICS_H
+
+#include "tracing/hash_trace.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tracing {
+
+/*
+ * Cost counters of a printer, registered with registerMetrics().
+ *
+ * The owning printer is the only writer, counters are updated with a plain
+ * relaxed load and store, so any thread can take a snapshot() without locks
+ * while printing goes on. Snapshot fields are each consistent on their own,
+ * not with one another.
+ *
+ * Levels come from the "I:", "W:", "E:" text prefix, or from the HashId
+ * type of HashTrace IDs. Span IDs and IDs passed as plain arrays are Other.
+ */
+class Metrics
+{
+public:
+  enum Level : uint8_t
+  {
+    Info,
+    Warning,
+    Error,
+    Other,
+  };
+
+  static constexpr size_t LevelCount = 4;
+  static constexpr size_t LatencyBuckets = 32;
+  static constexpr uint32_t SampleInterval = 64;
+
+  struct Snapshot
+  {
+    std::array<uint64_t, LevelCount> records;
+    std::array<uint64_t, LevelCount> bytes;
+    uint64_t drops;
+    uint64_t flushes;
+    uint64_t highWaterMark;
+    // Bucket i holds sampled print() latencies of [2^i, 2^(i+1)) cycles
+    std::array<uint64_t, LatencyBuckets> latency;
+  };
+
+  static constexpr auto SelfTrace = HashTrace::info("Tracing metrics: records {} bytes {} drops {} flushes {} high-water {}");
+
+public:
+  constexpr Metrics()
+    : m_records{}
+    , m_bytes{}
+    , m_drops(0)
+    , m_flushes(0)
+    , m_highWaterMark(0)
+    , m_latency{}
+    , m_sampleCountdown(SampleInterval)
+    , m_selfTracePeriod(0)
+    , m_selfTraceCountdown(0)
+  {
+  }
+
+  // Printers emit SelfTrace every period records, 0 disables it
+  void registerSelfTrace(uint64_t period);
+
+  Snapshot snapshot() const;
+
+  static constexpr Level level(char mark)
+  {
+    switch (mark) {
+      case 'I':
+        return Level::Info;
+      case 'W':
+        return Level::Warning;
+      case 'E':
+        return Level::Error;
+      default:
+        return Level::Other;
+    }
+  }
+
+  static constexpr Level level(const char* text)
+  {
+    if (!text || text[0] == 0 || text[1] != ':') {
+      return Level::Other;
+    }
+    return level(text[0]);
+  }
+
+  static uint64_t cycles();
+
+public:
+  // Writer side, used by the printers
+  bool sample();
+  void addRecord(Level level, size_t bytes);
+  void addLatency(uint64_t cycles);
+  void addDrop();
+  void addFlush();
+  void updateBufferUsage(size_t used);
+  bool selfTraceDue();
+
+private:
+  static void increment(std::atomic<uint64_t>& counter, uint64_t value = 1)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+private:
+  std::array<std::atomic<uint64_t>, LevelCount> m_records;
+  std::array<std::atomic<uint64_t>, LevelCount> m_bytes;
+  std::atomic<uint64_t> m_drops;
+  std::atomic<uint64_t> m_flushes;
+  std::atomic<uint64_t> m_highWaterMark;
+  std::array<std::atomic<uint64_t>, LatencyBuckets> m_latency;
+  uint32_t m_sampleCountdown;
+  uint64_t m_selfTracePeriod;
+  uint64_t m_selfTraceCountdown;
+};
+
+}
+
+#endif /* LIB_TRACING_METRICS_H */
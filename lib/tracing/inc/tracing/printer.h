@@ -1,12 +1,16 @@
 #ifndef LIB_TRACING_PRINTER_H
 #define LIB_TRACING_PRINTER_H
 
+#include "tracing/crc.h"
+#include "tracing/dictionary.h"
 #include "tracing/hashing.h"
+#include "tracing/intern.h"
+#include "tracing/metrics.h"
+#include "tracing/signature.h"
 
 #include <array>
-#include <charconv>
+#include <cstddef>
 #include <cstdint>
-#include <cstring>
 #include <type_traits>
 
 namespace tracing {
@@ -16,13 +20,41 @@ class Printer
 public:
   using OutputFunction = void (*)(const char);
 
+  /*
+   * How color marks reach the output: ANSI escapes for terminals, nothing
+   * for files and decoders, or CompactColorMark followed by the SGR code
+   * as one byte, which decoders turn back into escapes when displaying.
+   */
+  enum class Profile : uint8_t
+  {
+    Ansi,
+    Plain,
+    Compact,
+  };
+
+  static constexpr char CompactColorMark = 0x1A;
+
 public:
   constexpr Printer()
     : m_out(nullptr)
+    , m_intern(nullptr)
+    , m_metrics(nullptr)
+    , m_dictionary(nullptr)
+    , m_written(0)
+    , m_syncInterval(0)
+    , m_syncRecords(0)
+    , m_syncSequence(0)
+    , m_profile(Profile::Ansi)
   {
   }
 
   void registerOutput(OutputFunction out);
+  void registerInternTable(InternTable* table);
+  void registerMetrics(Metrics* metrics);
+  void registerDictionary(const Dictionary* dictionary);
+  void registerSyncInterval(uint32_t records);
+  void registerProfile(Profile profile);
+  void printHeader(const char* buildId);
   void printEndLine();
 
   template<typename... Args>
@@ -31,6 +63,12 @@ public:
   template<typename T, size_t size, typename... Args>
   void print(const std::array<T, size> text, Args... arguments);
 
+  template<char level, typename... Args>
+  void print(const HashId<level>& id, Args... arguments);
+
+  template<char level, typename... Types, typename... Args>
+  void print(const TypedTrace<level, Types...>& trace, Args... arguments);
+
 protected:
   enum Color : char
   {
@@ -58,11 +96,24 @@ protected:
   {
     if (m_out) {
       m_out(character);
+      m_written++;
+      if (m_syncInterval != 0) {
+        m_crc.update(character);
+      }
     }
   }
 
 protected:
   OutputFunction m_out;
+  InternTable* m_intern;
+  Metrics* m_metrics;
+  const Dictionary* m_dictionary;
+  uint64_t m_written;
+  Crc32 m_crc;
+  uint32_t m_syncInterval;
+  uint32_t m_syncRecords;
+  uint32_t m_syncSequence;
+  Profile m_profile;
 
 private:
   enum FormatType : uint32_t
@@ -79,7 +130,6 @@ private:
     End,
   };
 
-  static constexpr char EscCharacter = 0x1B;
   static constexpr unsigned int MaxDigits = 32;
   static constexpr char ArgumentStartMark = '{';
   static constexpr char ArgumentEndMark = '}';
@@ -87,6 +137,12 @@ private:
   static constexpr char ColorStartMark = '[';
   static constexpr char ColorEndMark = ']';
   static constexpr char ColorNumberMark = ArgumentFormatMark;
+  static constexpr char InternMark = '@';
+  static constexpr char InternDefinitionMark = '=';
+  static constexpr char StreamMark = '~';
+  static constexpr char HeaderMark = 'T';
+  static constexpr char SyncMark = 'S';
+  static constexpr unsigned int StreamVersion = 1;
 
 private:
   struct ArgumentFormat
@@ -99,223 +155,161 @@ private:
   };
 
 private:
-  template<typename Arg, typename... Args>
-  void mainPrint(const char* text, Arg argument, Args... arguments);
-  template<typename Arg, typename... Args>
-  void mainPrint(Arg argument, Args... arguments);
-  void mainPrint(const char* text);
+  /*
+   * Type-erased argument, every call site only packs its arguments into an
+   * array of these and the single formatting loop in printer.cpp does the rest.
+   */
+  struct Argument
+  {
+    enum Type : uint8_t
+    {
+      Bool,
+      Signed,
+      Unsigned,
+      Float,
+      Double,
+      Pointer,
+      String,
+      StringView,
+      Bytes,
+    };
+
+    struct Buffer
+    {
+      const void* data;
+      size_t size;
+    };
+
+    template<typename Arg>
+    static constexpr Argument from(Arg argument);
+
+    Type type;
+    union
+    {
+      bool boolean;
+      int64_t signedValue;
+      uint64_t unsignedValue;
+      double floating;
+      const void* pointer;
+      const char* string;
+      Buffer buffer;
+    };
+  };
+
+private:
+  template<typename... Args>
+  void mainPrint(const char* text, bool intern, Args... arguments);
+  template<typename... Args>
+  void mainPrint(Metrics::Level level, const char* text, Args... arguments);
+  const char* resolveId(const char* id) const;
+  void printRecord(const char* text, bool intern, const Argument* arguments, size_t count);
+  void printRecord(Metrics::Level level, const char* text, bool intern, const Argument* arguments, size_t count);
+  void printText(const char* text, bool intern, const Argument* arguments, size_t count);
+  void printSelfTrace();
+  void printSync();
+  void printFormatted(const char* text, const Argument* arguments, size_t count);
+  void printInternId(uint32_t id);
+  void printDefinition(uint32_t id, const char* text);
 
   bool parseColorMark(const char*& text);
-  template<typename Arg>
-  bool parseArgumentMark(const char*& text, Arg argument);
+  bool parseArgumentMark(const char*& text, const Argument& argument);
   void updateFormat(char text, ArgumentFormat& format);
   void printBuffer(const char* buffer);
-
-  template<typename Arg>
-  void printArgument(Arg argument, ArgumentFormat format, std::enable_if_t<std::is_same_v<Arg, bool>>* = nullptr);
-  template<typename Arg>
-  void printArgument(Arg argument,
-                     ArgumentFormat format,
-                     std::enable_if_t<std::is_integral_v<Arg> && !std::is_same_v<Arg, bool>>* = nullptr);
-  template<typename Arg>
-  void printArgument(Arg argument,
-                     ArgumentFormat format,
-                     std::enable_if_t<std::is_same_v<Arg, char*> || std::is_same_v<Arg, const char*>>* = nullptr);
+  void printBuffer(const char* buffer, size_t size);
+
+  void printArgument(const Argument& argument, ArgumentFormat format);
+  void printBool(bool argument);
+  void printInteger(uint64_t magnitude, bool lessThanZero, ArgumentFormat format);
+  void printFloating(double argument, bool single, ArgumentFormat format);
+  void printString(const char* argument, size_t size, ArgumentFormat format);
+  void printBytes(const std::byte* argument, size_t size);
 };
 
 template<typename... Args>
 void Printer::print(const char* text, Args... arguments)
 {
-  mainPrint(text, arguments...);
+  mainPrint(text, m_intern != nullptr, arguments...);
 }
 
 template<typename T, size_t size, typename... Args>
 void Printer::print(const std::array<T, size> text, Args... arguments)
 {
   if (text.back() != 0) {
-    mainPrint("Bad string. Missing Null terminator.");
+    mainPrint("Bad string. Missing Null terminator.", false);
     return;
   }
   const char* data = reinterpret_cast<const char*>(text.data());
-  mainPrint(data, arguments...);
-}
-
-template<typename Arg, typename... Args>
-void Printer::mainPrint(const char* text, Arg argument, Args... arguments)
-{
-  while (*text) {
-    if (parseArgumentMark(text, argument)) {
-      mainPrint(text, arguments...);
-      return;
-    } else if (parseColorMark(text)) {
-      mainPrint(text, argument, arguments...);
-      return;
-    } else {
-      putChar(*text);
-      text++;
-    }
+  if constexpr (size == Dictionary::IdSize + 1) {
+    static_assert(!(isByteSpan<Args> || ...), "Byte blobs read like integers after a hashed ID, pass them in a typed trace");
+    data = resolveId(data);
   }
-  mainPrint(argument, arguments...);
+  mainPrint(data, false, arguments...);
 }
 
-template<typename Arg, typename... Args>
-void Printer::mainPrint(Arg argument, Args... arguments)
+template<char level, typename... Args>
+void Printer::print(const HashId<level>& id, Args... arguments)
 {
-  constexpr ArgumentFormat format = {
-    .type = FormatType::Hex,
-  };
-  putChar(' ');
-  printArgument(argument, format);
-  if constexpr (sizeof...(Args) > 0) {
-    mainPrint(arguments...);
-    return;
-  } else {
-    printEndLine();
-  }
+  static_assert(!(isByteSpan<Args> || ...), "Byte blobs read like integers after a hashed ID, pass them in a typed trace");
+  mainPrint(Metrics::level(level), resolveId(reinterpret_cast<const char*>(id.data())), arguments...);
 }
 
-template<typename Arg>
-bool Printer::parseArgumentMark(const char*& text, Arg argument)
+template<char level, typename... Types, typename... Args>
+void Printer::print(const TypedTrace<level, Types...>& trace, Args... arguments)
 {
-  if (*text == ArgumentStartMark) {
-    text++;
-    ArgumentFormat format;
-    if (*text == ArgumentFormatMark) {
-      text++;
-      while (*text != ArgumentEndMark) {
-        updateFormat(*text, format);
-        text++;
-      }
-      text++;
-      printArgument(argument, format);
-      return true;
-    } else if (*text == ArgumentEndMark) {
-      text++;
-      printArgument(argument, format);
-      return true;
-    } else {
-      text--;
-    }
+  static_assert(TypedTrace<level, Types...>::template matches<Args...>(), "Trace arguments do not match the declared signature");
+  if (!TypedTrace<level, Types...>::fits(arguments...)) {
+    mainPrint("Typed trace argument out of range.", false);
+    return;
   }
-  return false;
+  // Decoders know the argument types from the signature, byte blobs included
+  mainPrint(Metrics::level(level), resolveId(reinterpret_cast<const char*>(trace.id.data())), static_cast<Types>(arguments)...);
 }
 
-template<typename Arg>
-void Printer::printArgument(Arg argument, ArgumentFormat format, std::enable_if_t<std::is_same_v<Arg, bool>>*)
+template<typename... Args>
+void Printer::mainPrint(const char* text, bool intern, Args... arguments)
 {
-  if (argument) {
-    if (m_out) {
-      m_out('t');
-      m_out('r');
-      m_out('u');
-      m_out('e');
-    }
-  } else {
-    if (m_out) {
-      m_out('f');
-      m_out('a');
-      m_out('l');
-      m_out('s');
-      m_out('e');
-    }
-  }
+  const std::array<Argument, sizeof...(Args)> list = { Argument::from(arguments)... };
+  printRecord(text, intern, list.data(), list.size());
 }
 
-template<typename Arg>
-void Printer::printArgument(Arg argument, ArgumentFormat format, std::enable_if_t<std::is_integral_v<Arg> && !std::is_same_v<Arg, bool>>*)
+template<typename... Args>
+void Printer::mainPrint(Metrics::Level level, const char* text, Args... arguments)
 {
-  char buffer[MaxDigits] = {};
-  bool lessThanZero = false;
-
-  uint32_t base = static_cast<uint32_t>(format.type);
-
-  if (argument < 0) {
-    argument *= -1;
-    lessThanZero = true;
-  }
-
-  std::to_chars(buffer, buffer + MaxDigits, argument, base);
-  uint32_t size = std::strlen(buffer);
-  if (lessThanZero) {
-    size++;
-  }
-
-  auto printAlign = [&](char character) {
-    if (format.width > size) {
-      for (uint32_t i = 0; i < (format.width - size); i++) {
-        if (m_out)
-          m_out(character);
-      }
-    }
-  };
-
-  if ((format.align == Align::Start) && !format.padding) {
-    printAlign(' ');
-  }
-
-  if (lessThanZero) {
-    putChar('-');
-  }
-
-  if (format.alternateFormat) {
-    switch (format.type) {
-      case FormatType::Hex:
-        size += 2;
-        if (m_out) {
-          m_out('0');
-          m_out('x');
-        }
-        break;
-      case FormatType::Bin:
-        size += 2;
-        if (m_out) {
-          m_out('0');
-          m_out('b');
-        }
-        break;
-      case FormatType::Oct:
-        size += 1;
-        putChar('0');
-      default:
-        break;
-    }
-  }
-
-  if (format.padding && format.align != Align::End) {
-    printAlign('0');
-  }
-
-  printBuffer(buffer);
-
-  if (format.align == Align::End) {
-    printAlign(' ');
-  }
+  const std::array<Argument, sizeof...(Args)> list = { Argument::from(arguments)... };
+  printRecord(level, text, false, list.data(), list.size());
 }
 
 template<typename Arg>
-void Printer::printArgument(Arg argument,
-                            ArgumentFormat format,
-                            std::enable_if_t<std::is_same_v<Arg, char*> || std::is_same_v<Arg, const char*>>*)
+constexpr Printer::Argument Printer::Argument::from(Arg argument)
 {
-  uint32_t size = std::strlen(argument);
-
-  auto printAlign = [&](char character) {
-    if (format.width > size) {
-      for (uint32_t i = 0; i < (format.width - size); i++) {
-        putChar(character);
-      }
-    }
-  };
-
-  if (format.align == Align::Start) {
-    printAlign(' ');
-  }
-
-  printBuffer(argument);
-
-  if (format.align == Align::End) {
-    printAlign(' ');
+  Argument result{};
+  if constexpr (std::is_same_v<Arg, bool>) {
+    result.type = Type::Bool;
+    result.boolean = argument;
+  } else if constexpr (std::is_integral_v<Arg> && std::is_signed_v<Arg>) {
+    result.type = Type::Signed;
+    result.signedValue = argument;
+  } else if constexpr (std::is_integral_v<Arg>) {
+    result.type = Type::Unsigned;
+    result.unsignedValue = argument;
+  } else if constexpr (std::is_floating_point_v<Arg>) {
+    result.type = sizeof(Arg) == sizeof(float) ? Type::Float : Type::Double;
+    result.floating = argument;
+  } else if constexpr (isCharPointer<Arg>) {
+    result.type = Type::String;
+    result.string = argument;
+  } else if constexpr (isDataPointer<Arg>) {
+    result.type = Type::Pointer;
+    result.pointer = argument;
+  } else if constexpr (std::is_same_v<Arg, std::string_view>) {
+    result.type = Type::StringView;
+    result.buffer = { argument.data(), argument.size() };
+  } else {
+    static_assert(isByteSpan<Arg>, "Unsupported argument type");
+    result.type = Type::Bytes;
+    result.buffer = { argument.data(), argument.size() };
   }
+  return result;
 }
 
 }
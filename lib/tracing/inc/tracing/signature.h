@@ -0,0 +1,186 @@
+#ifndef LIB_TRACING_SIGNATURE_H
+#define LIB_TRACING_SIGNATURE_H
+
+#include "tracing/hashing.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace tracing {
+
+template<typename T>
+constexpr bool isCharPointer = std::is_same_v<T, char*> || std::is_same_v<T, const char*>;
+
+template<typename T>
+constexpr bool isDataPointer = std::is_pointer_v<T> && !isCharPointer<T>;
+
+template<typename T>
+constexpr bool isByteSpan = std::is_same_v<T, std::span<const std::byte>> || std::is_same_v<T, std::span<std::byte>>;
+
+/*
+ * Argument type codes, the same characters are used by Python struct module
+ * so decoders can unpack fixed size arguments directly. Strings are 's'.
+ */
+template<typename T, typename = void>
+struct TypeCode
+{
+  static_assert(!std::is_same_v<T, T>, "Unsupported trace argument type");
+};
+
+template<>
+struct TypeCode<bool>
+{
+  static constexpr char value = '?';
+};
+
+template<typename T>
+struct TypeCode<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+{
+  static constexpr char value = [] {
+    constexpr bool isSigned = std::is_signed_v<T>;
+    switch (sizeof(T)) {
+      case 1:
+        return isSigned ? 'b' : 'B';
+      case 2:
+        return isSigned ? 'h' : 'H';
+      case 4:
+        return isSigned ? 'i' : 'I';
+      default:
+        return isSigned ? 'q' : 'Q';
+    }
+  }();
+};
+
+template<typename T>
+struct TypeCode<T, std::enable_if_t<std::is_floating_point_v<T>>>
+{
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Unsupported floating point width");
+  static constexpr char value = sizeof(T) == 4 ? 'f' : 'd';
+};
+
+template<typename T>
+struct TypeCode<T, std::enable_if_t<isCharPointer<T> || std::is_same_v<T, std::string_view>>>
+{
+  static constexpr char value = 's';
+};
+
+// Pointers are stored as 64-bit addresses on every target
+template<typename T>
+struct TypeCode<T, std::enable_if_t<isDataPointer<T>>>
+{
+  static constexpr char value = 'P';
+};
+
+// Byte blobs are not a Python struct code, they are stored like strings
+template<typename T>
+struct TypeCode<T, std::enable_if_t<isByteSpan<T>>>
+{
+  static constexpr char value = 'y';
+};
+
+template<typename... Types>
+constexpr std::array<char, sizeof...(Types)> typeSignature()
+{
+  return { TypeCode<std::decay_t<Types>>::value... };
+}
+
+static_assert(typeSignature<>().empty());
+static_assert(typeSignature<bool, int8_t, uint16_t, int32_t, uint64_t, const char*>() ==
+              std::array<char, 6>{ '?', 'b', 'H', 'i', 'Q', 's' });
+static_assert(typeSignature<float, double, const void*, std::string_view, std::span<const std::byte>>() ==
+              std::array<char, 5>{ 'f', 'd', 'P', 's', 'y' });
+
+/*
+ * The argument kind (bool, integer, floating point, string, pointer, bytes)
+ * has to match at the call site. Any integer type is taken for a declared
+ * integer, whether its value fits is checked when printing, see fitsArgument().
+ * Floating point converts to the declared width.
+ */
+template<typename Declared, typename Passed>
+constexpr bool isSameArgumentKind()
+{
+  using D = std::decay_t<Declared>;
+  using P = std::decay_t<Passed>;
+  if constexpr (std::is_same_v<D, bool> || std::is_same_v<P, bool>) {
+    return std::is_same_v<D, P>;
+  } else if constexpr (std::is_integral_v<D>) {
+    return std::is_integral_v<P>;
+  } else if constexpr (std::is_floating_point_v<D>) {
+    return std::is_floating_point_v<P>;
+  } else if constexpr (std::is_same_v<D, std::string_view>) {
+    return isCharPointer<P> || std::is_same_v<P, std::string_view>;
+  } else if constexpr (isCharPointer<D>) {
+    return isCharPointer<P>;
+  } else if constexpr (isDataPointer<D>) {
+    return isDataPointer<P> && std::is_convertible_v<P, D>;
+  } else {
+    return isByteSpan<P> && std::is_convertible_v<P, D>;
+  }
+}
+
+/*
+ * Arguments are not constant expressions inside print(), so a plain literal
+ * like 7 for a uint16_t is an int there. Its value is checked instead: an
+ * integer which does not fit the declared type would decode as another
+ * number. The check folds away for types which always fit.
+ */
+template<typename Declared, typename Passed>
+constexpr bool fitsArgument(Passed value)
+{
+  if constexpr (std::is_integral_v<Declared> && !std::is_same_v<Declared, bool>) {
+    return std::in_range<Declared>(value);
+  } else {
+    return true;
+  }
+}
+
+/*
+ * HashTrace ID which keeps its level mark ('I', 'W', 'E', or 'B' and 'F'
+ * of spans) in the type.
+ * The "<level>:" prefix is hashed with the text and cannot be read back
+ * from the ID, printers take it from here to count and route the record.
+ */
+template<char level>
+struct HashId : std::array<unsigned char, (Md5HashLen * 2) + 1>
+{
+  static constexpr char LevelMark = level;
+};
+
+template<char level, typename... Types>
+struct TypedTrace
+{
+  HashId<level> id;
+
+  template<typename... Args>
+  static constexpr bool matches()
+  {
+    if constexpr (sizeof...(Types) != sizeof...(Args)) {
+      return false;
+    } else {
+      return (isSameArgumentKind<Types, Args>() && ...);
+    }
+  }
+
+  template<typename... Args>
+  static constexpr bool fits(Args... arguments)
+  {
+    return (fitsArgument<Types>(arguments) && ...);
+  }
+};
+
+static_assert(TypedTrace<'I', uint16_t, int64_t, double>::matches<uint8_t, int32_t, float>());
+static_assert(TypedTrace<'I', uint8_t, float>::matches<int, double>());
+static_assert(!TypedTrace<'I', int>::matches<double>());
+static_assert(!TypedTrace<'I', uint8_t>::matches<bool>());
+static_assert(TypedTrace<'I', uint8_t, int16_t>::fits(0xFF, -2));
+static_assert(!TypedTrace<'I', uint8_t>::fits(0x1FF));
+static_assert(!TypedTrace<'I', uint16_t>::fits(-1));
+
+}
+
+#endif /* LIB_TRACING_SIGNATURE_H */
@@ -0,0 +1,77 @@
+#ifndef LIB_TRACING_SPAN_H
+#define LIB_TRACING_SPAN_H
+
+#include "tracing/hashing.h"
+
+#include <array>
+#include <cstdint>
+
+namespace tracing {
+
+/*
+ * Begin and end IDs of a duration span, hashed from "B:<text>" and
+ * "F:<text>" ("E:" is taken by errors).
+ */
+struct SpanTrace
+{
+  std::array<unsigned char, (Md5HashLen * 2) + 1> begin;
+  std::array<unsigned char, (Md5HashLen * 2) + 1> end;
+};
+
+class SpanClock
+{
+public:
+  using TimestampFunction = uint64_t (*)();
+
+public:
+  // Steady clock nanoseconds are used until another source is registered
+  static void registerTimestamp(TimestampFunction timestamp);
+
+  static uint64_t now() { return s_timestamp(); }
+
+  // Small sequential ID, assigned on the first span of every thread
+  static uint32_t threadId()
+  {
+    thread_local const uint32_t id = nextThreadId();
+    return id;
+  }
+
+private:
+  static uint64_t steadyTimestamp();
+  static uint32_t nextThreadId();
+
+private:
+  static inline TimestampFunction s_timestamp = steadyTimestamp;
+};
+
+/*
+ * Scoped duration span, prints the begin ID when created and the end ID
+ * when destroyed. Both records lead with the timestamp and the thread ID,
+ * begin records carry the optional arguments after them. Spans nest in
+ * scope order, so begin/end pairs match per thread in the decoder.
+ */
+template<typename PrinterType>
+class Span
+{
+public:
+  template<typename... Args>
+  Span(PrinterType& printer, const SpanTrace& trace, Args... arguments)
+    : m_printer(printer)
+    , m_end(trace.end)
+  {
+    m_printer.print(trace.begin, SpanClock::now(), SpanClock::threadId(), arguments...);
+  }
+
+  ~Span() { m_printer.print(m_end, SpanClock::now(), SpanClock::threadId()); }
+
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+private:
+  PrinterType& m_printer;
+  const std::array<unsigned char, (Md5HashLen * 2) + 1> m_end;
+};
+
+}
+
+#endif /* LIB_TRACING_SPAN_H */
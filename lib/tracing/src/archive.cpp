@@ -0,0 +1,296 @@
+#include "tracing/archive.h"
+
+#include <algorithm>
+
+namespace tracing {
+
+namespace {
+
+template<typename T>
+void store(uint8_t*& buffer, T value)
+{
+  for (unsigned int i = 0; i < sizeof(T); i++) {
+    *buffer++ = static_cast<uint8_t>(value >> (i * 8));
+  }
+}
+
+uint8_t fromHex(unsigned char character)
+{
+  if (character >= '0' && character <= '9') {
+    return character - '0';
+  } else if (character >= 'a' && character <= 'f') {
+    return character - 'a' + 10;
+  } else if (character >= 'A' && character <= 'F') {
+    return character - 'A' + 10;
+  }
+  return 0;
+}
+
+}
+
+ArchivePrinter::ArchivePrinter()
+  : m_out(nullptr)
+  , m_timestamp(nullptr)
+  , m_metrics(nullptr)
+  , m_offset(0)
+  , m_open(false)
+  , m_data{}
+  , m_used(0)
+  , m_records(0)
+  , m_begin(0)
+  , m_end(0)
+  , m_bloom{}
+  , m_ids{}
+  , m_idCount(0)
+  , m_defined{}
+{
+}
+
+void ArchivePrinter::registerOutput(OutputFunction out)
+{
+  m_out = out;
+}
+
+void ArchivePrinter::registerTimestamp(TimestampFunction timestamp)
+{
+  m_timestamp = timestamp;
+}
+
+void ArchivePrinter::registerMetrics(Metrics* metrics)
+{
+  m_metrics = metrics;
+}
+
+void ArchivePrinter::open()
+{
+  std::array<uint8_t, FileHeaderSize> header{};
+  uint8_t* buffer = header.data();
+  store<uint32_t>(buffer, FileMagic);
+  store<uint16_t>(buffer, FormatVersion);
+  store<uint16_t>(buffer, Md5HashLen);
+  store<uint32_t>(buffer, ChunkSize);
+  store<uint32_t>(buffer, 0);
+
+  m_offset = 0;
+  m_index.clear();
+  m_open = true;
+  write(header.data(), header.size());
+}
+
+void ArchivePrinter::flush()
+{
+  if (m_records == 0) {
+    return;
+  }
+
+  const size_t footerSize = FooterFixedSize + (m_idCount * IdCountEntrySize);
+
+  std::array<uint8_t, ChunkHeaderSize> header{};
+  uint8_t* buffer = header.data();
+  store<uint32_t>(buffer, ChunkMagic);
+  store<uint32_t>(buffer, m_used);
+  store<uint32_t>(buffer, m_records);
+  store<uint32_t>(buffer, footerSize);
+
+  std::array<uint8_t, MaxFooterSize> footer{};
+  buffer = footer.data();
+  store<uint64_t>(buffer, m_begin);
+  store<uint64_t>(buffer, m_end);
+  std::copy(m_bloom.begin(), m_bloom.end(), buffer);
+  buffer += m_bloom.size();
+  store<uint32_t>(buffer, m_idCount);
+  for (size_t i = 0; i < m_idCount; i++) {
+    std::copy(m_ids[i].id.begin(), m_ids[i].id.end(), buffer);
+    buffer += Md5HashLen;
+    store<uint32_t>(buffer, m_ids[i].count);
+  }
+
+  m_index.push_back({
+    .offset = m_offset,
+    .size = static_cast<uint32_t>(ChunkHeaderSize + m_used + footerSize),
+    .records = m_records,
+    .begin = m_begin,
+    .end = m_end,
+  });
+
+  write(header.data(), header.size());
+  write(m_data.data(), m_used);
+  write(footer.data(), footerSize);
+
+  if (m_metrics) {
+    m_metrics->addFlush();
+  }
+
+  m_used = 0;
+  m_records = 0;
+  m_begin = 0;
+  m_end = 0;
+  m_bloom.fill(0);
+  m_idCount = 0;
+  m_defined.reset();
+}
+
+void ArchivePrinter::close()
+{
+  if (!m_open) {
+    return;
+  }
+
+  flush();
+
+  const uint64_t indexOffset = m_offset;
+  for (const auto& entry : m_index) {
+    std::array<uint8_t, IndexEntrySize> data{};
+    uint8_t* buffer = data.data();
+    store<uint64_t>(buffer, entry.offset);
+    store<uint32_t>(buffer, entry.size);
+    store<uint32_t>(buffer, entry.records);
+    store<uint64_t>(buffer, entry.begin);
+    store<uint64_t>(buffer, entry.end);
+    write(data.data(), data.size());
+  }
+
+  std::array<uint8_t, TrailerSize> trailer{};
+  uint8_t* buffer = trailer.data();
+  store<uint64_t>(buffer, indexOffset);
+  store<uint32_t>(buffer, m_index.size());
+  store<uint32_t>(buffer, TrailerMagic);
+  write(trailer.data(), trailer.size());
+
+  m_open = false;
+}
+
+ArchivePrinter::TraceId ArchivePrinter::parseId(const unsigned char* text)
+{
+  TraceId id{};
+  for (unsigned int i = 0; i < id.size(); i++) {
+    id[i] = (fromHex(text[i * 2]) << 4) | fromHex(text[(i * 2) + 1]);
+  }
+  return id;
+}
+
+bool ArchivePrinter::reserve(size_t size)
+{
+  if (size > ChunkDataSize) {
+    drop();
+    return false;
+  }
+
+  if (m_used + size > ChunkDataSize) {
+    flush();
+  }
+  if (m_metrics) {
+    m_metrics->updateBufferUsage(m_used + size);
+  }
+  return true;
+}
+
+bool ArchivePrinter::reserve(size_t size, const TraceId& id)
+{
+  bool full = m_idCount == MaxChunkIds;
+  for (size_t i = 0; full && i < m_idCount; i++) {
+    full = m_ids[i].id != id;
+  }
+
+  if (full) {
+    flush();
+  }
+  return reserve(size);
+}
+
+void ArchivePrinter::drop()
+{
+  if (m_metrics) {
+    m_metrics->addDrop();
+  }
+}
+
+void ArchivePrinter::beginRecord(RecordKind kind, size_t arguments)
+{
+  const uint64_t timestamp = m_timestamp ? m_timestamp() : 0;
+  if (m_records == 0 || timestamp < m_begin) {
+    m_begin = timestamp;
+  }
+  if (m_records == 0 || timestamp > m_end) {
+    m_end = timestamp;
+  }
+
+  putValue<uint8_t>(kind);
+  putValue<uint8_t>(arguments);
+  putValue<uint64_t>(timestamp);
+  m_records++;
+}
+
+void ArchivePrinter::beginTrace(RecordKind kind, Metrics::Level level, const TraceId& id, size_t arguments, size_t size)
+{
+  if (m_metrics) {
+    m_metrics->addRecord(level, size);
+  }
+  beginRecord(kind, arguments);
+  putBytes(id.data(), id.size());
+  countId(id);
+}
+
+uint32_t ArchivePrinter::internId(const char* text)
+{
+  auto entry = m_intern.intern(text);
+  if (entry.id == InternTable::InvalidId) {
+    // Records already written keep their definitions, IDs reused from here on are defined again
+    m_intern.clear();
+    m_defined.reset();
+    entry = m_intern.intern(text);
+  }
+  return entry.id;
+}
+
+void ArchivePrinter::beginInterned(uint32_t id, const char* text, size_t arguments, size_t size)
+{
+  // Invalid ID (full intern table) is defined again before every use
+  if (id == InternTable::InvalidId || !m_defined[id]) {
+    const size_t definitionStart = m_used;
+    beginRecord(RecordKind::Definition, 0);
+    putValue<uint32_t>(id);
+    encodeValue(text);
+    m_defined[id] = true;
+    size += m_used - definitionStart;
+  }
+
+  if (m_metrics) {
+    m_metrics->addRecord(Metrics::level(text), size);
+  }
+
+  beginRecord(RecordKind::Interned, arguments);
+  putValue<uint32_t>(id);
+}
+
+void ArchivePrinter::countId(const TraceId& id)
+{
+  for (unsigned int i = 0; i < BloomFilterHashes; i++) {
+    const uint32_t bit = (id[i * 2] | (id[(i * 2) + 1] << 8)) % BloomFilterBits;
+    m_bloom[bit / 8] |= 1 << (bit % 8);
+  }
+
+  for (size_t i = 0; i < m_idCount; i++) {
+    if (m_ids[i].id == id) {
+      m_ids[i].count++;
+      return;
+    }
+  }
+  m_ids[m_idCount++] = { id, 1 };
+}
+
+void ArchivePrinter::putBytes(const void* data, size_t size)
+{
+  std::memcpy(&m_data[m_used], data, size);
+  m_used += size;
+}
+
+void ArchivePrinter::write(const uint8_t* data, size_t size)
+{
+  if (m_out) {
+    m_out(data, size);
+  }
+  m_offset += size;
+}
+
+}
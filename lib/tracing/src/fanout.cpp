@@ -0,0 +1,346 @@
+#include "tracing/fanout.h"
+
+#include <cstring>
+
+namespace tracing {
+
+namespace {
+
+// Printer and ArchivePrinter outputs take no context, the record being built is reached through these
+thread_local FanoutPrinter* s_capturePrinter = nullptr;
+thread_local std::vector<uint8_t>* s_staging = nullptr;
+
+constexpr char EscCharacter = 0x1B;
+
+void copyIn(std::vector<uint8_t>& ring, uint64_t position, const uint8_t* data, size_t size)
+{
+  const size_t offset = position % ring.size();
+  const size_t first = size < ring.size() - offset ? size : ring.size() - offset;
+  std::memcpy(&ring[offset], data, first);
+  std::memcpy(ring.data(), data + first, size - first);
+}
+
+void copyOut(const std::vector<uint8_t>& ring, uint64_t position, uint8_t* data, size_t size)
+{
+  const size_t offset = position % ring.size();
+  const size_t first = size < ring.size() - offset ? size : ring.size() - offset;
+  std::memcpy(data, &ring[offset], first);
+  std::memcpy(data + first, ring.data(), size - first);
+}
+
+uint32_t frameSize(const std::vector<uint8_t>& ring, uint64_t position)
+{
+  uint32_t size = 0;
+  copyOut(ring, position, reinterpret_cast<uint8_t*>(&size), sizeof(size));
+  return size;
+}
+
+}
+
+FanoutPrinter::FanoutPrinter()
+  : m_record{}
+  , m_recordSize(0)
+  , m_recordAnsi(true)
+  , m_plain{}
+{
+  m_printer.registerOutput(capture);
+}
+
+FanoutPrinter::~FanoutPrinter()
+{
+  stop();
+}
+
+bool FanoutPrinter::addSink(const SinkConfig& config)
+{
+  if (m_sinks.size() == MaxSinks || !config.write || config.capacity <= FrameHeaderSize) {
+    return false;
+  }
+
+  auto sink = std::make_unique<Sink>();
+  sink->config = config;
+  sink->ring.resize(config.capacity);
+  if (config.format == Format::Binary && config.capacity < MinBinaryCapacity) {
+    sink->ring.resize(MinBinaryCapacity);
+  }
+  if (config.format == Format::Binary) {
+    sink->archive = std::make_unique<ArchivePrinter>();
+    sink->archive->registerOutput(stage);
+  }
+  m_sinks.push_back(std::move(sink));
+  return true;
+}
+
+void FanoutPrinter::registerTimestamp(ArchivePrinter::TimestampFunction timestamp)
+{
+  for (auto& sink : m_sinks) {
+    if (sink->archive) {
+      sink->archive->registerTimestamp(timestamp);
+    }
+  }
+}
+
+void FanoutPrinter::open()
+{
+  for (auto& sink : m_sinks) {
+    if (sink->archive) {
+      beginBinary();
+      sink->archive->open();
+      endBinary(*sink);
+    }
+  }
+}
+
+void FanoutPrinter::close()
+{
+  for (auto& sink : m_sinks) {
+    if (sink->archive) {
+      beginBinary();
+      sink->archive->flush();
+      endBinary(*sink);
+
+      beginBinary();
+      sink->archive->close();
+      if (sink->brokenIndex) {
+        // Readers recover the chunks from their sync markers
+        m_staging.clear();
+      }
+      endBinary(*sink);
+    }
+  }
+}
+
+void FanoutPrinter::start()
+{
+  for (auto& sink : m_sinks) {
+    std::lock_guard lock(sink->mutex);
+    if (!sink->running) {
+      sink->running = true;
+      sink->writer = std::thread(&FanoutPrinter::run, this, std::ref(*sink));
+    }
+  }
+}
+
+void FanoutPrinter::stop()
+{
+  for (auto& sink : m_sinks) {
+    {
+      std::lock_guard lock(sink->mutex);
+      sink->running = false;
+    }
+    sink->written.notify_one();
+    if (sink->writer.joinable()) {
+      sink->writer.join();
+    }
+  }
+  drain();
+}
+
+void FanoutPrinter::drain()
+{
+  for (auto& sink : m_sinks) {
+    bool running = false;
+    {
+      std::lock_guard lock(sink->mutex);
+      running = sink->running;
+    }
+    if (!running) {
+      drain(*sink);
+    }
+  }
+}
+
+uint64_t FanoutPrinter::drops(size_t sink) const
+{
+  if (sink >= m_sinks.size()) {
+    return 0;
+  }
+  std::lock_guard lock(m_sinks[sink]->mutex);
+  return m_sinks[sink]->drops;
+}
+
+bool FanoutPrinter::accepts(const Sink& sink, Metrics::Level level)
+{
+  if (sink.config.level == Metrics::Level::Info) {
+    return true;
+  }
+  return level != Metrics::Level::Other && level >= sink.config.level;
+}
+
+void FanoutPrinter::capture(const char character)
+{
+  FanoutPrinter* printer = s_capturePrinter;
+  if (printer) {
+    // Characters past the buffer are only counted, endText() drops the record
+    if (printer->m_recordSize < MaxRecordSize) {
+      printer->m_record[printer->m_recordSize] = character;
+    }
+    printer->m_recordSize++;
+  }
+}
+
+void FanoutPrinter::stage(const uint8_t* data, size_t size)
+{
+  if (s_staging) {
+    s_staging->insert(s_staging->end(), data, data + size);
+  }
+}
+
+bool FanoutPrinter::beginText(Metrics::Level level)
+{
+  bool accepted = false;
+  bool ansi = false;
+  for (const auto& sink : m_sinks) {
+    if (!sink->archive && accepts(*sink, level)) {
+      accepted = true;
+      ansi = ansi || sink->config.format == Format::Ansi;
+    }
+  }
+  if (!accepted) {
+    return false;
+  }
+
+  // Colors are formatted only when a terminal sink takes the record
+  m_recordAnsi = ansi;
+  m_printer.registerProfile(ansi ? Printer::Profile::Ansi : Printer::Profile::Plain);
+  s_capturePrinter = this;
+  m_recordSize = 0;
+  return true;
+}
+
+void FanoutPrinter::endText(Metrics::Level level)
+{
+  s_capturePrinter = nullptr;
+
+  size_t plainSize = 0;
+  bool plainReady = false;
+  for (auto& sink : m_sinks) {
+    if (sink->archive || !accepts(*sink, level)) {
+      continue;
+    }
+
+    if (m_recordSize > MaxRecordSize) {
+      // A cut record would run into the next one, it is dropped as a whole
+      std::lock_guard lock(sink->mutex);
+      sink->drops++;
+      continue;
+    }
+
+    if (sink->config.format == Format::Ansi || !m_recordAnsi) {
+      push(*sink, reinterpret_cast<const uint8_t*>(m_record.data()), m_recordSize);
+      continue;
+    }
+
+    if (!plainReady) {
+      // Printer emits only "ESC [ <digits> m" sequences
+      for (size_t i = 0; i < m_recordSize; i++) {
+        if (m_record[i] == EscCharacter) {
+          while (i < m_recordSize && m_record[i] != 'm') {
+            i++;
+          }
+        } else {
+          m_plain[plainSize++] = m_record[i];
+        }
+      }
+      plainReady = true;
+    }
+    push(*sink, reinterpret_cast<const uint8_t*>(m_plain.data()), plainSize);
+  }
+}
+
+void FanoutPrinter::beginBinary()
+{
+  m_staging.clear();
+  s_staging = &m_staging;
+}
+
+void FanoutPrinter::endBinary(Sink& sink)
+{
+  s_staging = nullptr;
+  if (!m_staging.empty()) {
+    // Whole chunks are pushed at once, a drop never leaves part of a chunk
+    push(sink, m_staging.data(), m_staging.size());
+  }
+}
+
+void FanoutPrinter::push(Sink& sink, const uint8_t* data, size_t size)
+{
+  const size_t frame = FrameHeaderSize + size;
+  std::unique_lock lock(sink.mutex);
+
+  auto dropped = [&sink] {
+    sink.drops++;
+    if (sink.archive) {
+      sink.brokenIndex = true;
+    }
+  };
+
+  if (frame > sink.ring.size()) {
+    dropped();
+    return;
+  }
+
+  while (sink.ring.size() - (sink.head - sink.tail) < frame) {
+    if (sink.config.policy == Policy::DropNewest) {
+      dropped();
+      return;
+    } else if (sink.config.policy == Policy::DropOldest) {
+      sink.tail += FrameHeaderSize + frameSize(sink.ring, sink.tail);
+      dropped();
+    } else if (sink.running) {
+      sink.read.wait(lock);
+    } else {
+      // No writer thread, the producer delivers the records itself
+      lock.unlock();
+      drain(sink);
+      lock.lock();
+    }
+  }
+
+  const uint32_t header = size;
+  copyIn(sink.ring, sink.head, reinterpret_cast<const uint8_t*>(&header), FrameHeaderSize);
+  copyIn(sink.ring, sink.head + FrameHeaderSize, data, size);
+  sink.head += frame;
+  lock.unlock();
+  sink.written.notify_one();
+}
+
+bool FanoutPrinter::pop(Sink& sink)
+{
+  {
+    std::lock_guard lock(sink.mutex);
+    if (sink.head == sink.tail) {
+      return false;
+    }
+    const uint32_t size = frameSize(sink.ring, sink.tail);
+    sink.frame.resize(size);
+    copyOut(sink.ring, sink.tail + FrameHeaderSize, sink.frame.data(), size);
+    sink.tail += FrameHeaderSize + size;
+  }
+  sink.read.notify_one();
+
+  // The sink is written without the lock, the producer keeps filling the buffer meanwhile
+  sink.config.write(sink.frame.data(), sink.frame.size());
+  return true;
+}
+
+void FanoutPrinter::drain(Sink& sink)
+{
+  while (pop(sink)) {
+  }
+}
+
+void FanoutPrinter::run(Sink& sink)
+{
+  while (true) {
+    drain(sink);
+
+    std::unique_lock lock(sink.mutex);
+    sink.written.wait(lock, [&sink] { return sink.head != sink.tail || !sink.running; });
+    if (!sink.running && sink.head == sink.tail) {
+      return;
+    }
+  }
+}
+
+}
@@ -0,0 +1,108 @@
+#include "tracing/hit_counters.h"
+
+#include <charconv>
+
+namespace tracing {
+
+std::atomic<uint32_t> HitCounters::s_sites{ 0 };
+std::array<std::atomic<HitCounters::Row*>, HitCounters::MaxThreads> HitCounters::s_rows{};
+std::atomic<uint32_t> HitCounters::s_threads{ 0 };
+
+/*
+ * Tables are allocated on first use and never released, counts of finished
+ * threads stay in the dump.
+ */
+std::array<std::atomic<const unsigned char*>, HitCounters::MaxSites>& HitCounters::siteIds()
+{
+  static auto* const ids = new std::array<std::atomic<const unsigned char*>, MaxSites>{};
+  return *ids;
+}
+
+uint32_t HitCounters::registerSite(const unsigned char* id)
+{
+  const uint32_t claimed = s_sites.fetch_add(1, std::memory_order_relaxed);
+  if (claimed >= MaxSites) {
+    return InvalidSite;
+  }
+  siteIds()[claimed].store(id, std::memory_order_release);
+  return claimed;
+}
+
+HitCounters::Row* HitCounters::threadRow()
+{
+  thread_local Row* const row = acquireRow();
+  return row;
+}
+
+HitCounters::Row* HitCounters::acquireRow()
+{
+  const uint32_t index = s_threads.fetch_add(1, std::memory_order_relaxed);
+  if (index >= MaxThreads) {
+    return nullptr;
+  }
+  Row* row = new Row{};
+  s_rows[index].store(row, std::memory_order_release);
+  return row;
+}
+
+// Threads beyond MaxThreads share one row with atomic increments
+HitCounters::Row& HitCounters::sharedRow()
+{
+  static Row* const row = new Row{};
+  return *row;
+}
+
+uint32_t HitCounters::sites()
+{
+  const uint32_t sites = s_sites.load(std::memory_order_relaxed);
+  return sites < MaxSites ? sites : MaxSites;
+}
+
+uint64_t HitCounters::count(uint32_t site)
+{
+  if (site >= sites()) {
+    return 0;
+  }
+
+  const uint32_t threads = s_threads.load(std::memory_order_relaxed);
+  uint64_t count = threads > MaxThreads ? sharedRow().counts[site].load(std::memory_order_relaxed) : 0;
+  for (uint32_t i = 0; i < threads && i < MaxThreads; i++) {
+    // Claimed by a thread which did not store its row yet, nothing is counted there
+    const Row* row = s_rows[i].load(std::memory_order_acquire);
+    if (row) {
+      count += row->counts[site].load(std::memory_order_relaxed);
+    }
+  }
+  return count;
+}
+
+void HitCounters::dump(OutputFunction out)
+{
+  if (!out) {
+    return;
+  }
+
+  const uint32_t sites = HitCounters::sites();
+  for (uint32_t site = 0; site < sites; site++) {
+    const unsigned char* id = siteIds()[site].load(std::memory_order_acquire);
+    if (!id) {
+      // Claimed by another thread which did not store the ID yet
+      continue;
+    }
+
+    char buffer[2 * sizeof(uint64_t) + 1] = {};
+    std::to_chars(buffer, buffer + sizeof(buffer), count(site), 16);
+
+    out(CountMark);
+    for (size_t i = 0; i < Md5HashLen * 2; i++) {
+      out(id[i]);
+    }
+    out(' ');
+    for (const char* character = buffer; *character; character++) {
+      out(*character);
+    }
+    out('\n');
+  }
+}
+
+}
@@ -0,0 +1,74 @@
+#include "tracing/intern.h"
+
+#include <cstring>
+
+namespace tracing {
+
+InternTable::~InternTable()
+{
+  clear();
+}
+
+uint64_t InternTable::contentHash(const char* text)
+{
+  constexpr uint64_t FnvOffsetBasis = 0xCBF29CE484222325;
+  constexpr uint64_t FnvPrime = 0x100000001B3;
+
+  uint64_t hash = FnvOffsetBasis;
+  while (*text) {
+    hash = (hash ^ static_cast<uint8_t>(*text)) * FnvPrime;
+    text++;
+  }
+  return hash;
+}
+
+InternTable::Entry InternTable::intern(const char* text)
+{
+  const uint64_t hash = contentHash(text);
+
+  size_t probe = 0;
+  while (probe < MaxProbes) {
+    Slot& slot = m_slots[(hash + probe) % Capacity];
+    uint32_t id = slot.id.load(std::memory_order_acquire);
+
+    if (id == InvalidId) {
+      if (!slot.id.compare_exchange_strong(id, BusyId, std::memory_order_acquire)) {
+        // Lost the race for this slot, look at it again
+        continue;
+      }
+      // The caller's buffer may be reused or freed, the slot keeps its own copy
+      const size_t size = std::strlen(text) + 1;
+      slot.text = new char[size];
+      std::memcpy(slot.text, text, size);
+      slot.hash = hash;
+      id = m_nextId.fetch_add(1, std::memory_order_relaxed);
+      slot.id.store(id, std::memory_order_release);
+      return { id, true };
+    }
+
+    if (id != BusyId && slot.hash == hash && std::strcmp(slot.text, text) == 0) {
+      return { id, false };
+    }
+    probe++;
+  }
+  return { InvalidId, false };
+}
+
+void InternTable::clear()
+{
+  for (auto& slot : m_slots) {
+    if (slot.id.load(std::memory_order_relaxed) != InvalidId) {
+      delete[] slot.text;
+      slot.text = nullptr;
+      slot.id.store(InvalidId, std::memory_order_relaxed);
+    }
+  }
+  m_nextId.store(InvalidId + 1, std::memory_order_relaxed);
+}
+
+uint32_t InternTable::size() const
+{
+  return m_nextId.load(std::memory_order_relaxed) - 1;
+}
+
+}
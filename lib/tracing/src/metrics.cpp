@@ -0,0 +1,90 @@
+#include "tracing/metrics.h"
+
+#include <bit>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace tracing {
+
+void Metrics::registerSelfTrace(uint64_t period)
+{
+  m_selfTracePeriod = period;
+  m_selfTraceCountdown = period;
+}
+
+Metrics::Snapshot Metrics::snapshot() const
+{
+  Snapshot snapshot{};
+  for (size_t i = 0; i < LevelCount; i++) {
+    snapshot.records[i] = m_records[i].load(std::memory_order_relaxed);
+    snapshot.bytes[i] = m_bytes[i].load(std::memory_order_relaxed);
+  }
+  snapshot.drops = m_drops.load(std::memory_order_relaxed);
+  snapshot.flushes = m_flushes.load(std::memory_order_relaxed);
+  snapshot.highWaterMark = m_highWaterMark.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < LatencyBuckets; i++) {
+    snapshot.latency[i] = m_latency[i].load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+uint64_t Metrics::cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+bool Metrics::sample()
+{
+  if (--m_sampleCountdown != 0) {
+    return false;
+  }
+  m_sampleCountdown = SampleInterval;
+  return true;
+}
+
+void Metrics::addRecord(Level level, size_t bytes)
+{
+  increment(m_records[level]);
+  increment(m_bytes[level], bytes);
+}
+
+void Metrics::addLatency(uint64_t cycles)
+{
+  const size_t bucket = cycles == 0 ? 0 : std::bit_width(cycles) - 1;
+  increment(m_latency[bucket < LatencyBuckets ? bucket : LatencyBuckets - 1]);
+}
+
+void Metrics::addDrop()
+{
+  increment(m_drops);
+}
+
+void Metrics::addFlush()
+{
+  increment(m_flushes);
+}
+
+void Metrics::updateBufferUsage(size_t used)
+{
+  if (used > m_highWaterMark.load(std::memory_order_relaxed)) {
+    m_highWaterMark.store(used, std::memory_order_relaxed);
+  }
+}
+
+bool Metrics::selfTraceDue()
+{
+  if (m_selfTracePeriod == 0 || --m_selfTraceCountdown != 0) {
+    return false;
+  }
+  m_selfTraceCountdown = m_selfTracePeriod;
+  return true;
+}
+
+}
@@ -1,35 +1,135 @@
 #include "tracing/printer.h"
 
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
 namespace tracing {
 
+namespace {
+
+constexpr char EscCharacter = 0x1B;
+constexpr size_t AnsiColorSize = 5;
+constexpr size_t AnsiAttributeSize = 4;
+
+// "ESC [ <type> <color> m" for both color types, indexed by (type - '3') * 10 + color
+constexpr std::array<std::array<char, AnsiColorSize>, 20> makeAnsiColors()
+{
+  std::array<std::array<char, AnsiColorSize>, 20> escapes{};
+  for (size_t i = 0; i < escapes.size(); i++) {
+    escapes[i] = { EscCharacter, '[', static_cast<char>('3' + (i / 10)), static_cast<char>('0' + (i % 10)), 'm' };
+  }
+  return escapes;
+}
+
+constexpr std::array<std::array<char, AnsiAttributeSize>, 10> makeAnsiAttributes()
+{
+  std::array<std::array<char, AnsiAttributeSize>, 10> escapes{};
+  for (size_t i = 0; i < escapes.size(); i++) {
+    escapes[i] = { EscCharacter, '[', static_cast<char>('0' + i), 'm' };
+  }
+  return escapes;
+}
+
+constexpr auto AnsiColors = makeAnsiColors();
+constexpr auto AnsiAttributes = makeAnsiAttributes();
+
+}
+
 void Printer::registerOutput(OutputFunction out)
 {
   m_out = out;
 }
 
+void Printer::registerInternTable(InternTable* table)
+{
+  m_intern = table;
+}
+
+void Printer::registerMetrics(Metrics* metrics)
+{
+  m_metrics = metrics;
+}
+
+void Printer::registerDictionary(const Dictionary* dictionary)
+{
+  m_dictionary = dictionary;
+}
+
+void Printer::registerSyncInterval(uint32_t records)
+{
+  m_syncInterval = records;
+  m_syncRecords = 0;
+  m_crc.reset();
+}
+
+/*
+ * "~T<version> id=<hex ID length> hash=md5 endian=<le|be> build=<build ID>"
+ * tells decoders how to read the stream and which dictionary belongs to
+ * it, the build ID may hold letters, digits, '.', '_' and '-'. Sync
+ * blocks start over after it.
+ */
+void Printer::printHeader(const char* buildId)
+{
+  constexpr ArgumentFormat format;
+  putChar(StreamMark);
+  putChar(HeaderMark);
+  printInteger(StreamVersion, false, format);
+  printBuffer(" id=");
+  printInteger(Dictionary::IdSize, false, format);
+  printBuffer(" hash=md5 endian=");
+  printBuffer(std::endian::native == std::endian::little ? "le" : "be");
+  printBuffer(" build=");
+  printBuffer(buildId);
+  printEndLine();
+
+  m_crc.reset();
+  m_syncRecords = 0;
+  m_syncSequence = 0;
+}
+
 void Printer::printEndLine()
 {
   putChar('\n');
 }
 
+void Printer::registerProfile(Profile profile)
+{
+  m_profile = profile;
+}
+
 void Printer::printColorMark(char mark, char type)
 {
-  if (m_out) {
-    m_out(EscCharacter);
-    m_out('[');
-    m_out(type);
-    m_out(mark);
-    m_out('m');
+  const size_t code = ((type - ColorType::Foreground) * 10) + (mark - Black);
+  switch (m_profile) {
+    case Profile::Ansi:
+      printBuffer(AnsiColors[code].data(), AnsiColorSize);
+      break;
+    case Profile::Compact:
+      // The SGR code itself, 30-39 foreground and 40-49 background
+      putChar(CompactColorMark);
+      putChar(static_cast<char>(code + 30));
+      break;
+    case Profile::Plain:
+      break;
   }
 }
 
 void Printer::printAttributeMark(char mark)
 {
-  if (m_out) {
-    m_out(EscCharacter);
-    m_out('[');
-    m_out(mark);
-    m_out('m');
+  const size_t code = mark - '0';
+  switch (m_profile) {
+    case Profile::Ansi:
+      printBuffer(AnsiAttributes[code].data(), AnsiAttributeSize);
+      break;
+    case Profile::Compact:
+      putChar(CompactColorMark);
+      putChar(static_cast<char>(code));
+      break;
+    case Profile::Plain:
+      break;
   }
 }
 
@@ -93,17 +193,186 @@ void Printer::updateFormat(char text, ArgumentFormat& format)
   }
 }
 
-void Printer::mainPrint(const char* text)
+/*
+ * Builds with a compiled dictionary print hashed traces as their text.
+ * Spans stay hashed, their leading timestamp and thread ID are not
+ * arguments of the text.
+ */
+const char* Printer::resolveId(const char* id) const
 {
+  if (m_dictionary) {
+    const DictionaryEntry* entry = m_dictionary->find(id);
+    if (entry) {
+      const std::string_view text = entry->text;
+      return (text.starts_with("B:") || text.starts_with("F:")) ? id : entry->text;
+    }
+  }
+  return id;
+}
+
+void Printer::printRecord(const char* text, bool intern, const Argument* arguments, size_t count)
+{
+  printRecord(Metrics::level(text), text, intern, arguments, count);
+}
+
+void Printer::printRecord(Metrics::Level level, const char* text, bool intern, const Argument* arguments, size_t count)
+{
+  if (!m_metrics) {
+    printText(text, intern, arguments, count);
+  } else if (!m_out) {
+    m_metrics->addDrop();
+    return;
+  } else {
+    // Only every Metrics::SampleInterval record pays for reading the cycle counter
+    const bool sampled = m_metrics->sample();
+    const uint64_t start = sampled ? Metrics::cycles() : 0;
+    const uint64_t written = m_written;
+
+    printText(text, intern, arguments, count);
+
+    if (sampled) {
+      m_metrics->addLatency(Metrics::cycles() - start);
+    }
+    m_metrics->addRecord(level, m_written - written);
+    if (m_metrics->selfTraceDue()) {
+      printSelfTrace();
+    }
+  }
+
+  if (m_syncInterval != 0 && ++m_syncRecords >= m_syncInterval) {
+    printSync();
+  }
+}
+
+/*
+ * Interned text is sent once as "@<id>=<text>", later prints send only
+ * "@<id>" followed by the arguments, like hashed traces.
+ */
+void Printer::printText(const char* text, bool intern, const Argument* arguments, size_t count)
+{
+  if (intern) {
+    const auto entry = m_intern->intern(text);
+    if (entry.id != InternTable::InvalidId) {
+      if (entry.inserted) {
+        printDefinition(entry.id, text);
+      }
+      printInternId(entry.id);
+      text = "";
+    }
+  }
+  printFormatted(text, arguments, count);
+}
+
+/*
+ * Written past printRecord(), the self-trace is neither counted in the
+ * metrics nor toward the period, so it cannot trigger itself.
+ */
+void Printer::printSelfTrace()
+{
+  const auto snapshot = m_metrics->snapshot();
+  uint64_t records = 0;
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < Metrics::LevelCount; i++) {
+    records += snapshot.records[i];
+    bytes += snapshot.bytes[i];
+  }
+  const std::array<Argument, 5> list = { Argument::from(records),
+                                         Argument::from(bytes),
+                                         Argument::from(snapshot.drops),
+                                         Argument::from(snapshot.flushes),
+                                         Argument::from(snapshot.highWaterMark) };
+  printText(resolveId(reinterpret_cast<const char*>(Metrics::SelfTrace.data())), false, list.data(), list.size());
+}
+
+/*
+ * "~S<sequence> <CRC-32>" closes a block of m_syncInterval records, the
+ * CRC covers every byte written since the previous marker or header.
+ * Decoders joining mid-stream start at the next marker.
+ */
+void Printer::printSync()
+{
+  constexpr ArgumentFormat format = {
+    .type = FormatType::Hex,
+    .width = 8,
+    .padding = true,
+  };
+  const uint32_t crc = m_crc.value();
+  putChar(StreamMark);
+  putChar(SyncMark);
+  printInteger(m_syncSequence, false, format);
+  putChar(' ');
+  printInteger(crc, false, format);
+  printEndLine();
+
+  m_crc.reset();
+  m_syncRecords = 0;
+  m_syncSequence++;
+}
+
+void Printer::printFormatted(const char* text, const Argument* arguments, size_t count)
+{
+  size_t next = 0;
   while (*text) {
-    if (parseColorMark(text)) {
-      mainPrint(text);
-      return;
-    } else {
+    if (next < count && parseArgumentMark(text, arguments[next])) {
+      next++;
+    } else if (!parseColorMark(text)) {
       putChar(*text);
       text++;
     }
   }
+
+  // Arguments without a mark in the text (hashed traces) follow it in hex
+  constexpr ArgumentFormat format = {
+    .type = FormatType::Hex,
+  };
+  for (; next < count; next++) {
+    putChar(' ');
+    printArgument(arguments[next], format);
+  }
+  printEndLine();
+}
+
+bool Printer::parseArgumentMark(const char*& text, const Argument& argument)
+{
+  if (*text == ArgumentStartMark) {
+    text++;
+    ArgumentFormat format;
+    if (*text == ArgumentFormatMark) {
+      text++;
+      while (*text != ArgumentEndMark) {
+        updateFormat(*text, format);
+        text++;
+      }
+      text++;
+      printArgument(argument, format);
+      return true;
+    } else if (*text == ArgumentEndMark) {
+      text++;
+      printArgument(argument, format);
+      return true;
+    } else {
+      text--;
+    }
+  }
+  return false;
+}
+
+void Printer::printInternId(uint32_t id)
+{
+  constexpr ArgumentFormat format = {
+    .type = FormatType::Hex,
+    .width = 8,
+    .padding = true,
+  };
+  putChar(InternMark);
+  printInteger(id, false, format);
+}
+
+void Printer::printDefinition(uint32_t id, const char* text)
+{
+  printInternId(id);
+  putChar(InternDefinitionMark);
+  printBuffer(text);
   printEndLine();
 }
 
@@ -115,4 +384,164 @@ void Printer::printBuffer(const char* buffer)
   }
 }
 
+void Printer::printBuffer(const char* buffer, size_t size)
+{
+  for (size_t i = 0; i < size; i++) {
+    putChar(buffer[i]);
+  }
+}
+
+void Printer::printArgument(const Argument& argument, ArgumentFormat format)
+{
+  switch (argument.type) {
+    case Argument::Type::Bool:
+      printBool(argument.boolean);
+      break;
+    case Argument::Type::Signed:
+      if (argument.signedValue < 0) {
+        printInteger(0 - static_cast<uint64_t>(argument.signedValue), true, format);
+      } else {
+        printInteger(argument.signedValue, false, format);
+      }
+      break;
+    case Argument::Type::Unsigned:
+      printInteger(argument.unsignedValue, false, format);
+      break;
+    case Argument::Type::Float:
+    case Argument::Type::Double:
+      printFloating(argument.floating, argument.type == Argument::Type::Float, format);
+      break;
+    case Argument::Type::Pointer:
+      // "{}" prints like "{:#x}", trailing arguments stay plain hex
+      if (format.type == FormatType::Dec) {
+        format.type = FormatType::Hex;
+        format.alternateFormat = true;
+      }
+      printInteger(reinterpret_cast<uintptr_t>(argument.pointer), false, format);
+      break;
+    case Argument::Type::String:
+      printString(argument.string, std::strlen(argument.string), format);
+      break;
+    case Argument::Type::StringView:
+      printString(static_cast<const char*>(argument.buffer.data), argument.buffer.size, format);
+      break;
+    case Argument::Type::Bytes:
+      printBytes(static_cast<const std::byte*>(argument.buffer.data), argument.buffer.size);
+      break;
+  }
+}
+
+void Printer::printBool(bool argument)
+{
+  printBuffer(argument ? "true" : "false");
+}
+
+void Printer::printInteger(uint64_t magnitude, bool lessThanZero, ArgumentFormat format)
+{
+  char buffer[MaxDigits] = {};
+
+  uint32_t base = static_cast<uint32_t>(format.type);
+
+  std::to_chars(buffer, buffer + MaxDigits, magnitude, base);
+  uint32_t size = std::strlen(buffer);
+  if (lessThanZero) {
+    size++;
+  }
+
+  auto printAlign = [&](char character) {
+    if (format.width > size) {
+      for (uint32_t i = 0; i < (format.width - size); i++) {
+        putChar(character);
+      }
+    }
+  };
+
+  if ((format.align == Align::Start) && !format.padding) {
+    printAlign(' ');
+  }
+
+  if (lessThanZero) {
+    putChar('-');
+  }
+
+  if (format.alternateFormat) {
+    switch (format.type) {
+      case FormatType::Hex:
+        size += 2;
+        putChar('0');
+        putChar('x');
+        break;
+      case FormatType::Bin:
+        size += 2;
+        putChar('0');
+        putChar('b');
+        break;
+      case FormatType::Oct:
+        size += 1;
+        putChar('0');
+      default:
+        break;
+    }
+  }
+
+  if (format.padding && format.align != Align::End) {
+    printAlign('0');
+  }
+
+  printBuffer(buffer);
+
+  if (format.align == Align::End) {
+    printAlign(' ');
+  }
+}
+
+/*
+ * Shortest round-trip decimal, hex format (trailing arguments) gives the
+ * exact hex float which decoders read back with float.fromhex().
+ */
+void Printer::printFloating(double argument, bool single, ArgumentFormat format)
+{
+  char buffer[MaxDigits] = {};
+  std::to_chars_result result;
+  if (format.type == FormatType::Hex) {
+    result = single ? std::to_chars(buffer, buffer + MaxDigits, static_cast<float>(argument), std::chars_format::hex)
+                    : std::to_chars(buffer, buffer + MaxDigits, argument, std::chars_format::hex);
+  } else {
+    result = single ? std::to_chars(buffer, buffer + MaxDigits, static_cast<float>(argument))
+                    : std::to_chars(buffer, buffer + MaxDigits, argument);
+  }
+  printString(buffer, result.ptr - buffer, format);
+}
+
+void Printer::printString(const char* argument, size_t size, ArgumentFormat format)
+{
+  auto printAlign = [&](char character) {
+    if (format.width > size) {
+      for (uint32_t i = 0; i < (format.width - size); i++) {
+        putChar(character);
+      }
+    }
+  };
+
+  if (format.align == Align::Start) {
+    printAlign(' ');
+  }
+
+  printBuffer(argument, size);
+
+  if (format.align == Align::End) {
+    printAlign(' ');
+  }
+}
+
+void Printer::printBytes(const std::byte* argument, size_t size)
+{
+  constexpr char ascii[] = "0123456789abcdef";
+  for (size_t i = 0; i < size; i++) {
+    const uint8_t byte = std::to_integer<uint8_t>(argument[i]);
+    putChar(ascii[byte >> 4]);
+    putChar(ascii[byte & 0xF]);
+  }
+}
+
 }
@@ -0,0 +1,24 @@
+#include "tracing/span.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace tracing {
+
+void SpanClock::registerTimestamp(TimestampFunction timestamp)
+{
+  s_timestamp = timestamp ? timestamp : steadyTimestamp;
+}
+
+uint64_t SpanClock::steadyTimestamp()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t SpanClock::nextThreadId()
+{
+  static std::atomic<uint32_t> next{ 1 };
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,20 @@
+#include "ArchiveOutputBuffer.h"
+
+using namespace std;
+
+vector<uint8_t> ArchiveOutputBuffer::m_buffer;
+
+void ArchiveOutputBuffer::outputFunction(const uint8_t* data, size_t size)
+{
+  m_buffer.insert(m_buffer.end(), data, data + size);
+}
+
+const vector<uint8_t>& ArchiveOutputBuffer::getBuffer()
+{
+  return m_buffer;
+}
+
+void ArchiveOutputBuffer::clear()
+{
+  m_buffer.clear();
+}
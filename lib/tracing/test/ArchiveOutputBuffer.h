@@ -0,0 +1,29 @@
+#ifndef TRACING_TEST_ARCHIVE_OUTPUT_BUFFER_H
+#define TRACING_TEST_ARCHIVE_OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ArchiveOutputBuffer
+{
+public:
+  static void outputFunction(const uint8_t* data, size_t size);
+  static const std::vector<uint8_t>& getBuffer();
+  static void clear();
+
+  template<typename T>
+  static T read(size_t offset)
+  {
+    T value = 0;
+    for (unsigned int i = 0; i < sizeof(T); i++) {
+      value |= static_cast<T>(m_buffer.at(offset + i)) << (i * 8);
+    }
+    return value;
+  }
+
+private:
+  static std::vector<uint8_t> m_buffer;
+};
+
+#endif /* TRACING_TEST_ARCHIVE_OUTPUT_BUFFER_H */
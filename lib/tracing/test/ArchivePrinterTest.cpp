@@ -0,0 +1,285 @@
+#include "tracing/archive.h"
+#include "tracing/hash_trace.h"
+
+#include "ArchiveOutputBuffer.h"
+
+#include "gtest/gtest.h"
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ::testing;
+using namespace tracing;
+using namespace std;
+
+namespace {
+
+uint64_t CurrentTimestamp = 0;
+
+uint64_t getTimestamp()
+{
+  return CurrentTimestamp;
+}
+
+array<unsigned char, 33> makeId(unsigned int number)
+{
+  array<unsigned char, 33> id{};
+  char text[33] = {};
+  snprintf(text, sizeof(text), "%032x", number * 2654435761U);
+  copy(text, text + 32, id.begin());
+  return id;
+}
+
+}
+
+class ArchivePrinterTest : public Test
+{
+public:
+  ArchivePrinterTest()
+  {
+    ArchiveOutputBuffer::clear();
+    CurrentTimestamp = 0;
+    m_printer.registerOutput(ArchiveOutputBuffer::outputFunction);
+    m_printer.registerTimestamp(getTimestamp);
+    m_printer.open();
+  }
+
+  template<typename T>
+  T read(size_t offset)
+  {
+    return ArchiveOutputBuffer::read<T>(offset);
+  }
+
+  size_t size() { return ArchiveOutputBuffer::getBuffer().size(); }
+
+  void checkTrailer(uint32_t chunks)
+  {
+    ASSERT_GE(size(), ArchivePrinter::FileHeaderSize + ArchivePrinter::TrailerSize);
+    const size_t trailer = size() - ArchivePrinter::TrailerSize;
+    EXPECT_EQ(read<uint32_t>(trailer + 12), ArchivePrinter::TrailerMagic);
+    EXPECT_EQ(read<uint32_t>(trailer + 8), chunks);
+    EXPECT_EQ(read<uint64_t>(trailer), trailer - (chunks * ArchivePrinter::IndexEntrySize));
+  }
+
+protected:
+  ArchivePrinter m_printer;
+};
+
+TEST_F(ArchivePrinterTest, emptyArchive)
+{
+  m_printer.close();
+
+  ASSERT_EQ(size(), ArchivePrinter::FileHeaderSize + ArchivePrinter::TrailerSize);
+  EXPECT_EQ(read<uint32_t>(0), ArchivePrinter::FileMagic);
+  EXPECT_EQ(read<uint16_t>(4), ArchivePrinter::FormatVersion);
+  EXPECT_EQ(read<uint16_t>(6), Md5HashLen);
+  EXPECT_EQ(read<uint32_t>(8), ArchivePrinter::ChunkSize);
+  checkTrailer(0);
+}
+
+TEST_F(ArchivePrinterTest, recordLayout)
+{
+  constexpr auto trace = HashTrace::info("Archive {} test {} message {}");
+  CurrentTimestamp = 100;
+  m_printer.print(trace, 10, true, "abc");
+  CurrentTimestamp = 250;
+  m_printer.print(trace, -1, false, "");
+  m_printer.close();
+
+  const size_t chunk = ArchivePrinter::FileHeaderSize;
+  const uint32_t dataSize = read<uint32_t>(chunk + 4);
+  EXPECT_EQ(read<uint32_t>(chunk), ArchivePrinter::ChunkMagic);
+  EXPECT_EQ(read<uint32_t>(chunk + 8), 2U);
+
+  size_t record = chunk + ArchivePrinter::ChunkHeaderSize;
+  EXPECT_EQ(read<uint8_t>(record), ArchivePrinter::RecordKind::Trace);
+  EXPECT_EQ(read<uint8_t>(record + 1), 3U);
+  EXPECT_EQ(read<uint64_t>(record + 2), 100U);
+  EXPECT_EQ(read<uint8_t>(record + 10), 0x2F);
+  EXPECT_EQ(read<uint8_t>(record + 26), ArchivePrinter::ArgumentType::Signed);
+  EXPECT_EQ(read<uint64_t>(record + 27), 10U);
+  EXPECT_EQ(read<uint8_t>(record + 35), ArchivePrinter::ArgumentType::Bool);
+  EXPECT_EQ(read<uint8_t>(record + 36), 1U);
+  EXPECT_EQ(read<uint8_t>(record + 37), ArchivePrinter::ArgumentType::String);
+  EXPECT_EQ(read<uint16_t>(record + 38), 3U);
+  EXPECT_EQ(read<uint8_t>(record + 40), 'a');
+  EXPECT_EQ(dataSize, 2 * (26 + 9 + 2 + 3) + 3);
+
+  const size_t footer = chunk + ArchivePrinter::ChunkHeaderSize + dataSize;
+  EXPECT_EQ(read<uint64_t>(footer), 100U);
+  EXPECT_EQ(read<uint64_t>(footer + 8), 250U);
+  const size_t ids = footer + 16 + (ArchivePrinter::BloomFilterBits / 8);
+  EXPECT_EQ(read<uint32_t>(ids), 1U);
+  EXPECT_EQ(read<uint32_t>(ids + 4 + Md5HashLen), 2U);
+
+  checkTrailer(1);
+  const size_t index = size() - ArchivePrinter::TrailerSize - ArchivePrinter::IndexEntrySize;
+  EXPECT_EQ(read<uint64_t>(index), chunk);
+  EXPECT_EQ(read<uint32_t>(index + 8), ids + 4 + ArchivePrinter::IdCountEntrySize - chunk);
+  EXPECT_EQ(read<uint32_t>(index + 12), 2U);
+  EXPECT_EQ(read<uint64_t>(index + 16), 100U);
+  EXPECT_EQ(read<uint64_t>(index + 24), 250U);
+}
+
+TEST_F(ArchivePrinterTest, chunkPerIdLimit)
+{
+  for (unsigned int i = 0; i <= ArchivePrinter::MaxChunkIds; i++) {
+    CurrentTimestamp = i;
+    m_printer.print(makeId(i), i);
+  }
+  m_printer.close();
+
+  checkTrailer(2);
+  const size_t index = size() - ArchivePrinter::TrailerSize - (2 * ArchivePrinter::IndexEntrySize);
+  EXPECT_EQ(read<uint32_t>(index + 12), ArchivePrinter::MaxChunkIds);
+  EXPECT_EQ(read<uint32_t>(index + ArchivePrinter::IndexEntrySize + 12), 1U);
+  EXPECT_EQ(read<uint64_t>(index + ArchivePrinter::IndexEntrySize + 16), ArchivePrinter::MaxChunkIds);
+}
+
+TEST_F(ArchivePrinterTest, chunkSizeLimit)
+{
+  const string text(ArchivePrinter::MaxStringSize, 'x');
+  for (unsigned int i = 0; i < 128; i++) {
+    m_printer.print(makeId(0), text.c_str());
+  }
+  m_printer.close();
+
+  const uint32_t chunks = read<uint32_t>(size() - 8);
+  EXPECT_GT(chunks, 1U);
+  checkTrailer(chunks);
+
+  const size_t index = read<uint64_t>(size() - ArchivePrinter::TrailerSize);
+  uint32_t records = 0;
+  for (uint32_t i = 0; i < chunks; i++) {
+    const size_t entry = index + (i * ArchivePrinter::IndexEntrySize);
+    EXPECT_LE(read<uint32_t>(entry + 8), ArchivePrinter::ChunkSize);
+    EXPECT_EQ(read<uint32_t>(read<uint64_t>(entry)), ArchivePrinter::ChunkMagic);
+    records += read<uint32_t>(entry + 12);
+  }
+  EXPECT_EQ(records, 128U);
+}
+
+TEST_F(ArchivePrinterTest, typedRecordLayout)
+{
+  constexpr auto trace = HashTrace::warning<bool, int16_t, const char*>("Typed {} trace {} {}");
+  CurrentTimestamp = 7;
+  m_printer.print(trace, true, -2, "ab");
+  m_printer.close();
+
+  const size_t chunk = ArchivePrinter::FileHeaderSize;
+  EXPECT_EQ(read<uint32_t>(chunk + 4), 26U + 1 + 2 + 2 + 2);
+
+  size_t record = chunk + ArchivePrinter::ChunkHeaderSize;
+  EXPECT_EQ(read<uint8_t>(record), ArchivePrinter::RecordKind::Typed);
+  EXPECT_EQ(read<uint8_t>(record + 1), 3U);
+  EXPECT_EQ(read<uint64_t>(record + 2), 7U);
+  EXPECT_EQ(read<uint8_t>(record + 10), 0x72);
+  EXPECT_EQ(read<uint8_t>(record + 25), 0x04);
+  EXPECT_EQ(read<uint8_t>(record + 26), 1U);
+  EXPECT_EQ(read<uint16_t>(record + 27), 0xFFFEU);
+  EXPECT_EQ(read<uint16_t>(record + 29), 2U);
+  EXPECT_EQ(read<uint8_t>(record + 31), 'a');
+  EXPECT_EQ(read<uint8_t>(record + 32), 'b');
+}
+
+TEST_F(ArchivePrinterTest, extendedArgumentLayout)
+{
+  const array<std::byte, 2> blob = { std::byte{ 0xAB }, std::byte{ 0xCD } };
+  const int* pointer = reinterpret_cast<const int*>(0x1234);
+  m_printer.print(HashTrace::info("Extended {} {} {} {}"), 1.5F, pointer, string_view("xyz", 2), span<const std::byte>(blob));
+  m_printer.print(HashTrace::info<float, double, const void*, string_view, span<const std::byte>>("Typed {} {} {} {} {}"),
+                  1.5F,
+                  -2.0,
+                  pointer,
+                  "q",
+                  span<const std::byte>(blob));
+  m_printer.close();
+
+  size_t record = ArchivePrinter::FileHeaderSize + ArchivePrinter::ChunkHeaderSize + 26;
+  EXPECT_EQ(read<uint8_t>(record), ArchivePrinter::ArgumentType::Float);
+  EXPECT_EQ(read<uint64_t>(record + 1), 0x3FF8000000000000U);
+  EXPECT_EQ(read<uint8_t>(record + 9), ArchivePrinter::ArgumentType::Pointer);
+  EXPECT_EQ(read<uint64_t>(record + 10), 0x1234U);
+  EXPECT_EQ(read<uint8_t>(record + 18), ArchivePrinter::ArgumentType::String);
+  EXPECT_EQ(read<uint16_t>(record + 19), 2U);
+  EXPECT_EQ(read<uint8_t>(record + 22), 'y');
+  EXPECT_EQ(read<uint8_t>(record + 23), ArchivePrinter::ArgumentType::Bytes);
+  EXPECT_EQ(read<uint16_t>(record + 24), 2U);
+  EXPECT_EQ(read<uint8_t>(record + 27), 0xCD);
+
+  record += 28 + 26;
+  EXPECT_EQ(read<uint32_t>(record), 0x3FC00000U);
+  EXPECT_EQ(read<uint64_t>(record + 4), 0xC000000000000000U);
+  EXPECT_EQ(read<uint64_t>(record + 12), 0x1234U);
+  EXPECT_EQ(read<uint16_t>(record + 20), 1U);
+  EXPECT_EQ(read<uint8_t>(record + 22), 'q');
+  EXPECT_EQ(read<uint16_t>(record + 23), 2U);
+  EXPECT_EQ(read<uint8_t>(record + 25), 0xAB);
+}
+
+TEST_F(ArchivePrinterTest, internedRecordLayout)
+{
+  const string component = "Component {}";
+  m_printer.print(component.c_str(), 5U);
+  m_printer.print(component.c_str(), 6U);
+  m_printer.close();
+
+  const size_t chunk = ArchivePrinter::FileHeaderSize;
+  EXPECT_EQ(read<uint32_t>(chunk + 8), 3U);
+
+  size_t record = chunk + ArchivePrinter::ChunkHeaderSize;
+  EXPECT_EQ(read<uint8_t>(record), ArchivePrinter::RecordKind::Definition);
+  EXPECT_EQ(read<uint32_t>(record + 10), 1U);
+  EXPECT_EQ(read<uint16_t>(record + 14), component.size());
+  EXPECT_EQ(read<uint8_t>(record + 16), 'C');
+
+  record += 16 + component.size();
+  for (uint64_t value : { 5U, 6U }) {
+    EXPECT_EQ(read<uint8_t>(record), ArchivePrinter::RecordKind::Interned);
+    EXPECT_EQ(read<uint8_t>(record + 1), 1U);
+    EXPECT_EQ(read<uint32_t>(record + 10), 1U);
+    EXPECT_EQ(read<uint8_t>(record + 14), ArchivePrinter::ArgumentType::Unsigned);
+    EXPECT_EQ(read<uint64_t>(record + 15), value);
+    record += 23;
+  }
+
+  const size_t ids = record + 16 + (ArchivePrinter::BloomFilterBits / 8);
+  EXPECT_EQ(read<uint32_t>(ids), 0U);
+}
+
+TEST_F(ArchivePrinterTest, internedFullTableStartsOver)
+{
+  vector<string> texts;
+  for (size_t i = 0; i < InternTable::Capacity + 1; i++) {
+    texts.push_back("Text " + to_string(i));
+  }
+  for (const auto& text : texts) {
+    m_printer.print(text.c_str());
+  }
+  m_printer.close();
+
+  const size_t chunk = ArchivePrinter::FileHeaderSize;
+  const uint32_t records = read<uint32_t>(chunk + 8);
+  ASSERT_EQ(records, 2 * texts.size());
+
+  // Every text is new, each use follows its definition, and IDs start over once the table is full
+  size_t record = chunk + ArchivePrinter::ChunkHeaderSize;
+  size_t restarts = 0;
+  for (const auto& text : texts) {
+    ASSERT_EQ(read<uint8_t>(record), ArchivePrinter::RecordKind::Definition);
+    const uint32_t id = read<uint32_t>(record + 10);
+    EXPECT_NE(id, InternTable::InvalidId);
+    restarts += id == 1 ? 1 : 0;
+    EXPECT_EQ(read<uint16_t>(record + 14), text.size());
+    record += 16 + text.size();
+
+    ASSERT_EQ(read<uint8_t>(record), ArchivePrinter::RecordKind::Interned);
+    EXPECT_EQ(read<uint32_t>(record + 10), id);
+    record += 14;
+  }
+  EXPECT_EQ(restarts, 2U);
+}
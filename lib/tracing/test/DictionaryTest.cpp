@@ -0,0 +1,92 @@
+#include "tracing/dictionary.h"
+#include "tracing/hash_trace.h"
+#include "tracing/printer.h"
+
+#include "PrinterOutputBuffer.h"
+// Generated from this file: hash_map_gen.py <directory holding DictionaryTest.cpp> <output> --cpp
+#include "trace_dictionary.h"
+
+#include "gtest/gtest.h"
+#include <string>
+#include <string_view>
+
+using namespace ::testing;
+using namespace tracing;
+using namespace std;
+
+namespace {
+
+// Passed by name, so the generator does not see it
+constexpr char MissingText[] = "Not in the dictionary";
+
+string id(const array<unsigned char, (Md5HashLen * 2) + 1>& trace)
+{
+  return reinterpret_cast<const char*>(trace.data());
+}
+
+}
+
+class DictionaryTest : public Test
+{
+public:
+  DictionaryTest()
+  {
+    PrinterOutputBuffer::clear();
+    m_printer.registerOutput(PrinterOutputBuffer::outputFunction);
+  }
+
+protected:
+  Printer m_printer;
+};
+
+TEST_F(DictionaryTest, findGeneratedEntries)
+{
+  constexpr auto plain = HashTrace::info<"Dictionary plain trace">();
+  constexpr auto formatted = HashTrace::warning<"Dictionary value {} mask {:#x}">();
+  constexpr auto typed = HashTrace::error<"Dictionary typed {}", uint16_t>();
+
+  const DictionaryEntry* entry = generated::TraceDictionary.find(plain);
+  ASSERT_NE(nullptr, entry);
+  ASSERT_STREQ("I:Dictionary plain trace", entry->text);
+  ASSERT_STREQ("", entry->signature);
+
+  entry = generated::TraceDictionary.find(formatted);
+  ASSERT_NE(nullptr, entry);
+  ASSERT_STREQ("W:Dictionary value {} mask {:#x}", entry->text);
+
+  entry = generated::TraceDictionary.find(typed.id);
+  ASSERT_NE(nullptr, entry);
+  ASSERT_STREQ("E:Dictionary typed {}", entry->text);
+  ASSERT_STREQ("H", entry->signature);
+
+  // Every slot is reached from its own ID
+  for (const auto& generatedEntry : generated::TraceDictionaryEntries) {
+    ASSERT_EQ(&generatedEntry, generated::TraceDictionary.find(generatedEntry.id));
+  }
+}
+
+TEST_F(DictionaryTest, unknownIdsAreNotFound)
+{
+  ASSERT_EQ(nullptr, generated::TraceDictionary.find(HashTrace::info(MissingText)));
+  ASSERT_EQ(nullptr, generated::TraceDictionary.find("0123456789abcdef0123456789abcdef"));
+  ASSERT_EQ(nullptr, generated::TraceDictionary.find("not a hex trace id at all, sorry"));
+
+  constexpr const DictionaryEntry* entry = generated::TraceDictionary.find(HashTrace::info<"Dictionary plain trace">());
+  static_assert(string_view(entry->text) == "I:Dictionary plain trace");
+  static_assert(generated::TraceDictionary.find("0123456789abcdef0123456789abcdef") == nullptr);
+}
+
+TEST_F(DictionaryTest, printerDecodesHashedTraces)
+{
+  constexpr auto span = HashTrace::span("Dictionary span");
+  m_printer.registerDictionary(&generated::TraceDictionary);
+
+  m_printer.print(HashTrace::warning<"Dictionary value {} mask {:#x}">(), 12, 0xF0U);
+  m_printer.print(HashTrace::error<"Dictionary typed {}", uint16_t>(), 7);
+  m_printer.print(HashTrace::info(MissingText), 1);
+  m_printer.print(span.begin, 1, 2);
+
+  const string expected = "W:Dictionary value 12 mask 0xf0\nE:Dictionary typed 7\n" + id(HashTrace::info(MissingText)) + " 1\n"
+                          + id(span.begin) + " 1 2\n";
+  ASSERT_STREQ(expected.c_str(), PrinterOutputBuffer::getPointer());
+}
@@ -0,0 +1,159 @@
+#include "tracing/archive.h"
+#include "tracing/fanout.h"
+#include "tracing/hash_trace.h"
+#include "tracing/trace.h"
+
+#include "gtest/gtest.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using namespace tracing;
+using namespace std;
+
+namespace {
+
+array<string, 3> Outputs;
+
+template<size_t sink>
+void writeOutput(const uint8_t* data, size_t size)
+{
+  Outputs[sink].append(reinterpret_cast<const char*>(data), size);
+}
+
+uint32_t readU32(const string& data, size_t offset)
+{
+  uint32_t value = 0;
+  for (unsigned int i = 0; i < sizeof(value); i++) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(data.at(offset + i))) << (i * 8);
+  }
+  return value;
+}
+
+}
+
+class FanoutPrinterTest : public Test
+{
+public:
+  FanoutPrinterTest()
+  {
+    for (auto& output : Outputs) {
+      output.clear();
+    }
+  }
+
+protected:
+  FanoutPrinter m_printer;
+};
+
+TEST_F(FanoutPrinterTest, levelAndFormatPerSink)
+{
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<0> }));
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<1>, .level = Metrics::Level::Error, .format = FanoutPrinter::Format::Plain }));
+
+  constexpr auto hashedInfo = HashTrace::info("Hashed info");
+  constexpr auto hashedError = HashTrace::error("Hashed error");
+  m_printer.print(Trace::info("[:1]Info[] {}"), 1);
+  m_printer.print(Trace::error("[:1]Error[] {}"), 2);
+  m_printer.print(hashedInfo);
+  m_printer.print(hashedError);
+  m_printer.drain();
+
+  const string info = reinterpret_cast<const char*>(hashedInfo.data());
+  const string error = reinterpret_cast<const char*>(hashedError.data());
+  EXPECT_EQ(Outputs[0], "I:\x1B[31mInfo\x1B[39m 1\nE:\x1B[31mError\x1B[39m 2\n" + info + "\n" + error + "\n");
+  EXPECT_EQ(Outputs[1], "E:Error 2\n" + error + "\n");
+}
+
+TEST_F(FanoutPrinterTest, errorSinkTakesHashedErrors)
+{
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<0>, .level = Metrics::Level::Error, .format = FanoutPrinter::Format::Plain }));
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<1>, .level = Metrics::Level::Error, .format = FanoutPrinter::Format::Binary }));
+
+  constexpr auto typedError = HashTrace::error<"Typed error {}", int>();
+  m_printer.open();
+  m_printer.print(HashTrace::warning("Hashed warning"));
+  m_printer.print(typedError, 7);
+  m_printer.print(HashTrace::span("Span").begin);
+  m_printer.close();
+  m_printer.drain();
+
+  const string id = reinterpret_cast<const char*>(typedError.id.data());
+  EXPECT_EQ(Outputs[0], id + " 7\n");
+  ASSERT_GE(Outputs[1].size(), ArchivePrinter::FileHeaderSize + ArchivePrinter::TrailerSize);
+  EXPECT_EQ(readU32(Outputs[1], ArchivePrinter::FileHeaderSize + 8), 1U);
+}
+
+TEST_F(FanoutPrinterTest, binarySink)
+{
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<0>, .level = Metrics::Level::Warning }));
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<1>, .format = FanoutPrinter::Format::Binary }));
+
+  m_printer.open();
+  m_printer.print(HashTrace::info("Binary {}"), 5);
+  m_printer.print("W:Interned");
+  m_printer.close();
+  m_printer.drain();
+
+  EXPECT_EQ(Outputs[0], "W:Interned\n");
+  ASSERT_GE(Outputs[1].size(), ArchivePrinter::FileHeaderSize + ArchivePrinter::TrailerSize);
+  EXPECT_EQ(readU32(Outputs[1], 0), ArchivePrinter::FileMagic);
+  EXPECT_EQ(readU32(Outputs[1], ArchivePrinter::FileHeaderSize), ArchivePrinter::ChunkMagic);
+  EXPECT_EQ(readU32(Outputs[1], ArchivePrinter::FileHeaderSize + 8), 3U);
+  EXPECT_EQ(readU32(Outputs[1], Outputs[1].size() - 4), ArchivePrinter::TrailerMagic);
+}
+
+TEST_F(FanoutPrinterTest, dropPolicies)
+{
+  // Room for two "Record N\n" frames
+  constexpr size_t Capacity = 2 * (4 + 9);
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<0>, .policy = FanoutPrinter::Policy::DropNewest, .capacity = Capacity }));
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<1>, .policy = FanoutPrinter::Policy::DropOldest, .capacity = Capacity }));
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<2>, .policy = FanoutPrinter::Policy::Block, .capacity = Capacity }));
+
+  for (int i = 0; i < 4; i++) {
+    m_printer.print("Record {}", i);
+  }
+  m_printer.drain();
+
+  EXPECT_EQ(Outputs[0], "Record 0\nRecord 1\n");
+  EXPECT_EQ(m_printer.drops(0), 2U);
+  EXPECT_EQ(Outputs[1], "Record 2\nRecord 3\n");
+  EXPECT_EQ(m_printer.drops(1), 2U);
+  EXPECT_EQ(Outputs[2], "Record 0\nRecord 1\nRecord 2\nRecord 3\n");
+  EXPECT_EQ(m_printer.drops(2), 0U);
+}
+
+TEST_F(FanoutPrinterTest, dropsRecordOverLimit)
+{
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<0> }));
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<1>, .format = FanoutPrinter::Format::Plain }));
+
+  const string big(FanoutPrinter::MaxRecordSize + 500, 'x');
+  m_printer.print("{}", big.c_str());
+  m_printer.print("Next");
+  m_printer.drain();
+
+  EXPECT_EQ(Outputs[0], "Next\n");
+  EXPECT_EQ(m_printer.drops(0), 1U);
+  EXPECT_EQ(Outputs[1], "Next\n");
+  EXPECT_EQ(m_printer.drops(1), 1U);
+}
+
+TEST_F(FanoutPrinterTest, writerThreads)
+{
+  ASSERT_TRUE(m_printer.addSink({ .write = writeOutput<0>, .policy = FanoutPrinter::Policy::Block, .capacity = 64 }));
+  m_printer.start();
+
+  string expected;
+  for (int i = 0; i < 1000; i++) {
+    m_printer.print("Record {}", i);
+    expected += "Record " + to_string(i) + "\n";
+  }
+  m_printer.stop();
+
+  EXPECT_EQ(Outputs[0], expected);
+  EXPECT_EQ(m_printer.drops(0), 0U);
+}
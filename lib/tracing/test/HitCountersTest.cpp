@@ -0,0 +1,74 @@
+#include "tracing/hash_trace.h"
+#include "tracing/hit_counters.h"
+
+#include "PrinterOutputBuffer.h"
+
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+using namespace tracing;
+using namespace std;
+
+class HitCountersTest : public Test
+{
+public:
+  HitCountersTest() { PrinterOutputBuffer::clear(); }
+
+  // Sites are global, only the line of the given ID is looked at
+  string dumpLine(const unsigned char* id)
+  {
+    HitCounters::dump(PrinterOutputBuffer::outputFunction);
+    const string dump = PrinterOutputBuffer::getPointer();
+    const size_t begin = dump.find(string(1, HitCounters::CountMark) + reinterpret_cast<const char*>(id));
+    if (begin == string::npos) {
+      return {};
+    }
+    return dump.substr(begin, dump.find('\n', begin) - begin);
+  }
+};
+
+TEST_F(HitCountersTest, countedSite)
+{
+  constexpr auto trace = HashTrace::info("Counted site");
+  for (int i = 0; i < 0x12; i++) {
+    HitCounters::hit<trace>();
+  }
+
+  EXPECT_EQ(dumpLine(trace.data()), "%" + string(reinterpret_cast<const char*>(trace.data())) + " 12");
+}
+
+TEST_F(HitCountersTest, typedAndSpanSites)
+{
+  constexpr auto typed = HashTrace::warning<"Typed {}", bool>();
+  constexpr auto span = HashTrace::span("Counted span");
+  HitCounters::hit<typed>();
+  HitCounters::hit<span>();
+  HitCounters::hit<span>();
+
+  EXPECT_EQ(dumpLine(typed.id.data()), "%" + string(reinterpret_cast<const char*>(typed.id.data())) + " 1");
+  EXPECT_EQ(dumpLine(span.begin.data()), "%" + string(reinterpret_cast<const char*>(span.begin.data())) + " 2");
+}
+
+TEST_F(HitCountersTest, countsFromAllThreads)
+{
+  constexpr auto trace = HashTrace::error<"Threaded site">();
+  constexpr int Threads = 8;
+  constexpr int Hits = 10000;
+
+  vector<thread> threads;
+  for (int i = 0; i < Threads; i++) {
+    threads.emplace_back([] {
+      for (int j = 0; j < Hits; j++) {
+        HitCounters::hit<trace>();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(dumpLine(trace.data()), "%" + string(reinterpret_cast<const char*>(trace.data())) + " 13880");
+}
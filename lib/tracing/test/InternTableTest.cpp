@@ -0,0 +1,125 @@
+#include "tracing/intern.h"
+
+#include "gtest/gtest.h"
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+using namespace tracing;
+using namespace std;
+
+class InternTableTest : public Test
+{
+protected:
+  unique_ptr<InternTable> m_table = make_unique<InternTable>();
+};
+
+TEST_F(InternTableTest, samePointerSameText)
+{
+  const char* text = "Component name";
+
+  auto first = m_table->intern(text);
+  auto second = m_table->intern(text);
+
+  EXPECT_NE(first.id, InternTable::InvalidId);
+  EXPECT_TRUE(first.inserted);
+  EXPECT_EQ(second.id, first.id);
+  EXPECT_FALSE(second.inserted);
+  EXPECT_EQ(m_table->size(), 1U);
+}
+
+TEST_F(InternTableTest, reusedBufferNewText)
+{
+  char buffer[16] = "first";
+  auto first = m_table->intern(buffer);
+
+  snprintf(buffer, sizeof(buffer), "second");
+  auto second = m_table->intern(buffer);
+
+  EXPECT_TRUE(second.inserted);
+  EXPECT_NE(second.id, first.id);
+}
+
+TEST_F(InternTableTest, otherBufferSameText)
+{
+  const string first = "Same text";
+  auto firstEntry = m_table->intern(first.c_str());
+
+  char second[16] = {};
+  snprintf(second, sizeof(second), "Same %s", "text");
+  auto secondEntry = m_table->intern(second);
+
+  EXPECT_TRUE(firstEntry.inserted);
+  EXPECT_FALSE(secondEntry.inserted);
+  EXPECT_EQ(secondEntry.id, firstEntry.id);
+  EXPECT_EQ(m_table->size(), 1U);
+}
+
+TEST_F(InternTableTest, clearStartsOver)
+{
+  const auto first = m_table->intern("First");
+  m_table->intern("Second");
+  m_table->clear();
+
+  EXPECT_EQ(m_table->size(), 0U);
+  const auto second = m_table->intern("Second");
+  EXPECT_TRUE(second.inserted);
+  EXPECT_EQ(second.id, first.id);
+}
+
+TEST_F(InternTableTest, fullTable)
+{
+  vector<string> texts;
+  for (size_t i = 0; i < InternTable::Capacity + 1; i++) {
+    texts.push_back("Text " + to_string(i));
+  }
+
+  size_t interned = 0;
+  for (const auto& text : texts) {
+    interned += m_table->intern(text.c_str()).id != InternTable::InvalidId ? 1 : 0;
+  }
+
+  EXPECT_LE(interned, InternTable::Capacity);
+  EXPECT_EQ(m_table->size(), interned);
+}
+
+TEST_F(InternTableTest, concurrentIntern)
+{
+  constexpr size_t Threads = 8;
+  constexpr size_t Texts = 64;
+
+  vector<string> texts;
+  for (size_t i = 0; i < Texts; i++) {
+    texts.push_back("Concurrent " + to_string(i));
+  }
+
+  vector<array<uint32_t, Texts>> ids(Threads);
+  vector<thread> workers;
+  for (size_t t = 0; t < Threads; t++) {
+    workers.emplace_back([&, t] {
+      for (size_t round = 0; round < 100; round++) {
+        for (size_t i = 0; i < Texts; i++) {
+          ids[t][i] = m_table->intern(texts[i].c_str()).id;
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  set<uint32_t> unique;
+  for (size_t i = 0; i < Texts; i++) {
+    for (size_t t = 0; t < Threads; t++) {
+      EXPECT_NE(ids[t][i], InternTable::InvalidId);
+      EXPECT_EQ(ids[t][i], ids[0][i]);
+    }
+    unique.insert(ids[0][i]);
+  }
+  EXPECT_EQ(unique.size(), Texts);
+}
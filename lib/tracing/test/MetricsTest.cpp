@@ -0,0 +1,110 @@
+#include "tracing/archive.h"
+#include "tracing/hash_trace.h"
+#include "tracing/metrics.h"
+#include "tracing/printer.h"
+#include "tracing/trace.h"
+
+#include "ArchiveOutputBuffer.h"
+#include "PrinterOutputBuffer.h"
+
+#include "gtest/gtest.h"
+#include <numeric>
+#include <string>
+
+using namespace ::testing;
+using namespace tracing;
+using namespace std;
+
+class MetricsTest : public Test
+{
+public:
+  MetricsTest()
+  {
+    PrinterOutputBuffer::clear();
+    m_printer.registerOutput(PrinterOutputBuffer::outputFunction);
+    m_printer.registerMetrics(&m_metrics);
+  }
+
+protected:
+  Metrics m_metrics;
+  Printer m_printer;
+};
+
+TEST_F(MetricsTest, recordsAndBytesPerLevel)
+{
+  m_printer.print(Trace::info("Info {}"), 1);
+  m_printer.print(Trace::warning("Warning"));
+  m_printer.print(Trace::warning("Warning"));
+  m_printer.print(HashTrace::error("Hashed error"));
+  m_printer.print(HashTrace::error<"Typed error {}", bool>(), true);
+  m_printer.print(HashTrace::span("Span").begin, 1, 2);
+
+  const auto snapshot = m_metrics.snapshot();
+  EXPECT_EQ(snapshot.records[Metrics::Level::Info], 1U);
+  EXPECT_EQ(snapshot.records[Metrics::Level::Warning], 2U);
+  EXPECT_EQ(snapshot.records[Metrics::Level::Error], 2U);
+  EXPECT_EQ(snapshot.records[Metrics::Level::Other], 1U);
+  EXPECT_EQ(snapshot.bytes[Metrics::Level::Info], string("I:Info 1\n").size());
+  EXPECT_EQ(accumulate(snapshot.bytes.begin(), snapshot.bytes.end(), 0U), string(PrinterOutputBuffer::getPointer()).size());
+}
+
+TEST_F(MetricsTest, dropsWithoutOutput)
+{
+  m_printer.registerOutput(nullptr);
+  m_printer.print("Dropped");
+
+  const auto snapshot = m_metrics.snapshot();
+  EXPECT_EQ(snapshot.drops, 1U);
+  EXPECT_EQ(accumulate(snapshot.records.begin(), snapshot.records.end(), 0U), 0U);
+}
+
+TEST_F(MetricsTest, sampledLatency)
+{
+  for (uint32_t i = 0; i < Metrics::SampleInterval * 3; i++) {
+    m_printer.print("Sampled {}", i);
+  }
+
+  const auto snapshot = m_metrics.snapshot();
+  EXPECT_EQ(accumulate(snapshot.latency.begin(), snapshot.latency.end(), 0U), 3U);
+}
+
+TEST_F(MetricsTest, selfTrace)
+{
+  m_metrics.registerSelfTrace(2);
+  m_printer.print("First");
+  m_printer.print("Second");
+
+  const string selfTrace = reinterpret_cast<const char*>(Metrics::SelfTrace.data());
+  EXPECT_EQ(string(PrinterOutputBuffer::getPointer()), "First\nSecond\n" + selfTrace + " 2 d 0 0 0\n");
+}
+
+TEST_F(MetricsTest, selfTraceEveryRecord)
+{
+  // Self-traces are not records of their own, they neither count nor trigger another one
+  m_metrics.registerSelfTrace(1);
+  m_printer.print("First");
+  m_printer.print("Second");
+
+  const string selfTrace = reinterpret_cast<const char*>(Metrics::SelfTrace.data());
+  EXPECT_EQ(string(PrinterOutputBuffer::getPointer()), "First\n" + selfTrace + " 1 6 0 0 0\nSecond\n" + selfTrace + " 2 d 0 0 0\n");
+}
+
+TEST_F(MetricsTest, archiveFlushesAndDrops)
+{
+  ArchivePrinter archive;
+  archive.registerOutput(ArchiveOutputBuffer::outputFunction);
+  archive.registerMetrics(&m_metrics);
+
+  archive.print(HashTrace::info("Closed"));
+  archive.open();
+  archive.print(HashTrace::info("Open {}"), 1);
+  archive.print("I:Interned");
+  archive.close();
+
+  const auto snapshot = m_metrics.snapshot();
+  EXPECT_EQ(snapshot.drops, 1U);
+  EXPECT_EQ(snapshot.flushes, 1U);
+  EXPECT_EQ(snapshot.records[Metrics::Level::Other], 0U);
+  EXPECT_EQ(snapshot.records[Metrics::Level::Info], 2U);
+  EXPECT_EQ(snapshot.highWaterMark, snapshot.bytes[Metrics::Level::Info]);
+}
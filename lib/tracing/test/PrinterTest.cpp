@@ -1,11 +1,16 @@
+#include "tracing/hash_trace.h"
 #include "tracing/printer.h"
 
 #include "PrinterOutputBuffer.h"
 
 #include "gtest/gtest.h"
 #include <array>
+#include <bit>
+#include <cstddef>
 #include <fmt/core.h>  // TODO replace with std when available
+#include <span>
 #include <string>
+#include <string_view>
 #include <tuple>
 
 using namespace ::testing;
@@ -159,3 +164,93 @@ TEST_P(PrinterIntTest, formatArgumentPrint)
   m_printer.print(testMessage.c_str(), testIntArgument, testIntArgument, testIntArgument, testIntArgument);
   checkMessage(expectedMessage);
 }
+
+TEST_F(PrinterTest, typedTracePrint)
+{
+  constexpr auto trace = HashTrace::info<uint8_t, const char*, bool>("This is a {} typed {} test {} message");
+  const string expectedMessage = string(reinterpret_cast<const char*>(trace.id.data())) + " ab text true\n";
+
+  m_printer.print(trace, 0xAB, "text", true);
+  checkMessage(expectedMessage);
+}
+
+TEST_F(PrinterTest, typedTraceOutOfRange)
+{
+  // 0x1FF would decode as 0xFF, the record is replaced by an error
+  m_printer.print(HashTrace::info<"Out of range {}", uint8_t>(), 0x1FF);
+  checkMessage("Typed trace argument out of range.\n");
+}
+
+TEST_F(PrinterTest, internedPrint)
+{
+  InternTable table;
+  m_printer.registerInternTable(&table);
+
+  const string component = "Component {} name";
+  m_printer.print(component.c_str(), 0x12);
+  m_printer.print(component.c_str(), 0x34);
+  checkMessage("@00000001=Component {} name\n@00000001 12\n@00000001 34\n");
+}
+
+TEST_F(PrinterTest, limitArgumentPrint)
+{
+  string testMessage = "Limits {} {} {:#x}";
+  string expectedMessage = fmt::format("Limits {} {} {:#x}\n", INT64_MIN, INT8_MIN, UINT64_MAX);
+
+  m_printer.print(testMessage.c_str(), INT64_MIN, static_cast<int8_t>(INT8_MIN), UINT64_MAX);
+  checkMessage(expectedMessage);
+}
+
+TEST_F(PrinterTest, extendedArgumentPrint)
+{
+  const array<std::byte, 3> blob = { std::byte{ 0x01 }, std::byte{ 0xAB }, std::byte{ 0xFF } };
+  const int* pointer = reinterpret_cast<const int*>(0x1234);
+
+  m_printer.print("{} {} {:>6}| {} {} {}", 0.1, 0.1F, 2.5, pointer, string_view("view text", 4), span<const std::byte>(blob));
+  checkMessage("0.1 0.1    2.5| 0x1234 view 01abff\n");
+}
+
+TEST_F(PrinterTest, extendedTrailingArgumentPrint)
+{
+  constexpr auto trace = HashTrace::info("Extended trailing");
+  const string expectedMessage = string(reinterpret_cast<const char*>(trace.data())) + " 1.8p+1 -1p-1 1234\n";
+
+  m_printer.print(trace, 3.0, -0.5F, reinterpret_cast<const void*>(0x1234));
+  checkMessage(expectedMessage);
+}
+
+TEST_F(PrinterTest, streamHeaderPrint)
+{
+  const string endian = std::endian::native == std::endian::little ? "le" : "be";
+
+  m_printer.printHeader("1.4.0-rc1_g3a2f");
+  checkMessage("~T1 id=32 hash=md5 endian=" + endian + " build=1.4.0-rc1_g3a2f\n");
+}
+
+TEST_F(PrinterTest, syncMarkerPrint)
+{
+  m_printer.registerSyncInterval(2);
+
+  m_printer.print("First record");
+  m_printer.print("Second record {}", 1);
+  m_printer.print("Third record");
+  m_printer.print("Fourth record");
+  checkMessage("First record\nSecond record 1\n~S00000000 131238ed\nThird record\nFourth record\n~S00000001 82f9c9e6\n");
+}
+
+TEST_F(PrinterTest, plainProfilePrint)
+{
+  m_printer.registerProfile(Printer::Profile::Plain);
+
+  m_printer.print("[:1]Red[] and [:b4]blue {}[:b] text", 7);
+  checkMessage("Red and blue 7 text\n");
+}
+
+TEST_F(PrinterTest, compactProfilePrint)
+{
+  m_printer.registerProfile(Printer::Profile::Compact);
+
+  m_printer.print("[:1]Red[] and [:b4]blue[:b]");
+  checkMessage("\x1A\x1FRed\x1A\x27 and \x1A\x2C"
+               "blue\x1A\x31\n");
+}
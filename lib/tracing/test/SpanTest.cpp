@@ -0,0 +1,85 @@
+#include "tracing/hash_trace.h"
+#include "tracing/printer.h"
+#include "tracing/span.h"
+
+#include "PrinterOutputBuffer.h"
+
+#include "gtest/gtest.h"
+#include <fmt/core.h>  // TODO replace with std when available
+#include <string>
+#include <thread>
+
+using namespace ::testing;
+using namespace tracing;
+using namespace std;
+
+namespace {
+
+uint64_t s_time = 0;
+
+uint64_t fakeTimestamp()
+{
+  return ++s_time;
+}
+
+string id(const array<unsigned char, (Md5HashLen * 2) + 1>& trace)
+{
+  return reinterpret_cast<const char*>(trace.data());
+}
+
+}
+
+class SpanTest : public Test
+{
+public:
+  SpanTest()
+  {
+    s_time = 0;
+    SpanClock::registerTimestamp(fakeTimestamp);
+    PrinterOutputBuffer::clear();
+    m_printer.registerOutput(PrinterOutputBuffer::outputFunction);
+  }
+
+  ~SpanTest() { SpanClock::registerTimestamp(nullptr); }
+
+protected:
+  Printer m_printer;
+};
+
+TEST_F(SpanTest, beginAndEndRecords)
+{
+  constexpr auto trace = HashTrace::span("Parse {} bytes");
+  const uint32_t thread = SpanClock::threadId();
+  {
+    Span span(m_printer, trace, 0x40);
+  }
+
+  const string expected = fmt::format("{} 1 {:x} 40\n{} 2 {:x}\n", id(trace.begin), thread, id(trace.end), thread);
+  ASSERT_STREQ(expected.c_str(), PrinterOutputBuffer::getPointer());
+}
+
+TEST_F(SpanTest, nestedSpans)
+{
+  constexpr auto outer = HashTrace::span<"Outer">();
+  constexpr auto inner = HashTrace::span<"Inner">();
+  const uint32_t thread = SpanClock::threadId();
+  {
+    Span outerSpan(m_printer, outer);
+    Span innerSpan(m_printer, inner);
+  }
+
+  const string expected = fmt::format(
+    "{0} 1 {4:x}\n{1} 2 {4:x}\n{2} 3 {4:x}\n{3} 4 {4:x}\n", id(outer.begin), id(inner.begin), id(inner.end), id(outer.end), thread);
+  ASSERT_STREQ(expected.c_str(), PrinterOutputBuffer::getPointer());
+}
+
+TEST_F(SpanTest, threadIdPerThread)
+{
+  const uint32_t thread = SpanClock::threadId();
+  uint32_t other = 0;
+  std::thread worker([&other] { other = SpanClock::threadId(); });
+  worker.join();
+
+  EXPECT_EQ(thread, SpanClock::threadId());
+  EXPECT_NE(thread, other);
+}
@@ -0,0 +1,27 @@
+// Generated by hash_map_gen.py, do not edit
+#ifndef TRACE_DICTIONARY_H
+#define TRACE_DICTIONARY_H
+
+#include "tracing/dictionary.h"
+
+namespace tracing::generated {
+
+inline constexpr std::array<uint32_t, 3> TraceDictionaryBuckets = {
+  0x00000000,
+  0x00000001,
+  0x0000000c,
+};
+
+inline constexpr std::array<DictionaryEntry, 5> TraceDictionaryEntries = { {
+  { "c4c78533d7ada6c653f035d7cb41fc80", "F:Dictionary span", "" },
+  { "b1086741fac638aea1e9363cc3a49294", "W:Dictionary value {} mask {:#x}", "" },
+  { "e7ae60edd3aae1c7ca6042315fed0ff1", "E:Dictionary typed {}", "H" },
+  { "b20658444c95eae4e65dd6fdf97fdc7f", "I:Dictionary plain trace", "" },
+  { "fd1a4cc6fa97534798d027475ea79ad0", "B:Dictionary span", "" },
+} };
+
+inline constexpr Dictionary TraceDictionary(TraceDictionaryBuckets, TraceDictionaryEntries);
+
+}
+
+#endif /* TRACE_DICTIONARY_H */
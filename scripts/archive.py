@@ -0,0 +1,277 @@
+import argparse
+import mmap
+import struct
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Collection, Iterator, Optional
+
+from dictionary import TraceEntry, format_trace, load_trace_map, render_colors
+
+FILE_MAGIC = 0x41525448
+CHUNK_MAGIC = 0x4B435448
+TRAILER_MAGIC = 0x58495448
+FORMAT_VERSION = 1
+
+FILE_HEADER = struct.Struct("<IHHII")
+CHUNK_HEADER = struct.Struct("<IIII")
+INDEX_ENTRY = struct.Struct("<QIIQQ")
+TRAILER = struct.Struct("<QII")
+RECORD_HEADER = struct.Struct("<BBQ16s")
+RECORD_PREFIX = struct.Struct("<BBQ")
+
+BLOOM_FILTER_BITS = 2048
+BLOOM_FILTER_HASHES = 4
+FOOTER_TIME_RANGE = struct.Struct("<QQ")
+FOOTER_FIXED_SIZE = FOOTER_TIME_RANGE.size + BLOOM_FILTER_BITS // 8 + 4
+ID_COUNT_ENTRY_SIZE = 20
+# Larger ID sets pass almost every chunk bloom filter, checking them costs more than the scan saves
+MAX_BLOOM_IDS = 64
+
+RECORD_TRACE = 1
+RECORD_TYPED = 2
+RECORD_DEFINITION = 3
+RECORD_INTERNED = 4
+INTERNED_ID = struct.Struct("<I")
+
+ARGUMENT_BOOL = 1
+ARGUMENT_SIGNED = 2
+ARGUMENT_UNSIGNED = 3
+ARGUMENT_STRING = 4
+ARGUMENT_FLOAT = 5
+ARGUMENT_POINTER = 6
+ARGUMENT_BYTES = 7
+
+# Pointers are stored as 64-bit addresses, the native only struct code 'P' is read as 'Q'
+FIXED_CODES = {"P": "Q"}
+
+
+@dataclass
+class Chunk:
+    offset: int
+    size: int
+    records: int
+    begin: int
+    end: int
+
+
+@dataclass
+class Record:
+    timestamp: int
+    id: str
+    args: list
+    text: Optional[str] = None
+
+
+def bloom_bits(trace_id: bytes) -> list[int]:
+    return [(trace_id[i * 2] | (trace_id[i * 2 + 1] << 8)) % BLOOM_FILTER_BITS for i in range(BLOOM_FILTER_HASHES)]
+
+
+def decode_blob(data, offset: int) -> tuple[bytes, int]:
+    (length,) = struct.unpack_from("<H", data, offset)
+    offset += 2
+    return bytes(data[offset : offset + length]), offset + length
+
+
+def decode_arguments(data, offset: int, count: int) -> tuple[list, int]:
+    args = []
+    for _ in range(count):
+        kind = data[offset]
+        offset += 1
+        if kind == ARGUMENT_BOOL:
+            args.append(bool(data[offset]))
+            offset += 1
+        elif kind == ARGUMENT_SIGNED:
+            args.append(struct.unpack_from("<q", data, offset)[0])
+            offset += 8
+        elif kind in (ARGUMENT_UNSIGNED, ARGUMENT_POINTER):
+            args.append(struct.unpack_from("<Q", data, offset)[0])
+            offset += 8
+        elif kind == ARGUMENT_FLOAT:
+            args.append(struct.unpack_from("<d", data, offset)[0])
+            offset += 8
+        elif kind in (ARGUMENT_STRING, ARGUMENT_BYTES):
+            value, offset = decode_blob(data, offset)
+            args.append(value.decode("utf-8", errors="replace") if kind == ARGUMENT_STRING else value)
+        else:
+            raise ValueError(f"Unknown argument type {kind} at offset {offset - 1}")
+    return args, offset
+
+
+def decode_typed_arguments(data, offset: int, signature: str) -> tuple[list, int]:
+    args = []
+    for code in signature:
+        if code in ("s", "y"):
+            value, offset = decode_blob(data, offset)
+            args.append(value.decode("utf-8", errors="replace") if code == "s" else value)
+        else:
+            code = FIXED_CODES.get(code, code)
+            args.append(struct.unpack_from("<" + code, data, offset)[0])
+            offset += struct.calcsize("<" + code)
+    return args, offset
+
+
+def decode_records(data, offset: int, end: int, trace_hash_map: dict[str, TraceEntry]) -> Iterator[Record]:
+    """Records of one chunk. A typed record missing in the dictionary (a stale one) ends the chunk with a warning."""
+    interned = {}
+    while offset < end:
+        kind, count, timestamp = RECORD_PREFIX.unpack_from(data, offset)
+        if kind in (RECORD_DEFINITION, RECORD_INTERNED):
+            # Runtime strings are defined again in every chunk they are used in
+            (runtime_id,) = INTERNED_ID.unpack_from(data, offset + RECORD_PREFIX.size)
+            offset += RECORD_PREFIX.size + INTERNED_ID.size
+            if kind == RECORD_DEFINITION:
+                text, offset = decode_typed_arguments(data, offset, "s")
+                interned[runtime_id] = text[0]
+                continue
+            args, offset = decode_arguments(data, offset, count)
+            yield Record(timestamp, f"@{runtime_id:08x}", args, interned.get(runtime_id))
+            continue
+
+        _, _, _, raw_id = RECORD_HEADER.unpack_from(data, offset)
+        trace_id = raw_id.hex()
+        offset += RECORD_HEADER.size
+        if kind == RECORD_TRACE:
+            args, offset = decode_arguments(data, offset, count)
+        elif kind == RECORD_TYPED:
+            # Typed records carry no type tags, argument layout comes from the dictionary signature
+            entry = trace_hash_map.get(trace_id)
+            if entry is None or len(entry.signature) != count:
+                # Its size is unknown without the signature, the next record cannot be found
+                print(f"# typed trace {trace_id} is missing in the dictionary, rest of the chunk is skipped", file=sys.stderr)
+                return
+            args, offset = decode_typed_arguments(data, offset, entry.signature)
+        else:
+            raise ValueError(f"Unknown record kind {kind} at offset {offset - RECORD_HEADER.size}")
+        yield Record(timestamp, trace_id, args)
+
+
+def scan_chunks(data, chunk_size: int, start: int, stop: int) -> Iterator[Chunk]:
+    """Find chunks by their sync marker, used when the archive index is missing or to split a byte range."""
+    marker = struct.pack("<I", CHUNK_MAGIC)
+    offset = data.find(marker, start, stop)
+    while offset != -1 and offset + CHUNK_HEADER.size <= len(data):
+        _, data_size, records, footer_size = CHUNK_HEADER.unpack_from(data, offset)
+        size = CHUNK_HEADER.size + data_size + footer_size
+        footer = offset + CHUNK_HEADER.size + data_size
+        valid = records > 0 and footer_size >= FOOTER_FIXED_SIZE and size <= chunk_size and offset + size <= len(data)
+        if valid:
+            (id_count,) = struct.unpack_from("<I", data, footer + FOOTER_FIXED_SIZE - 4)
+            valid = footer_size == FOOTER_FIXED_SIZE + id_count * ID_COUNT_ENTRY_SIZE
+        if valid:
+            begin, end = FOOTER_TIME_RANGE.unpack_from(data, footer)
+            yield Chunk(offset, size, records, begin, end)
+            offset = data.find(marker, offset + size, stop)
+        else:
+            offset = data.find(marker, offset + 1, stop)
+
+
+def format_record(record: Record, trace_hash_map: dict[str, TraceEntry], color: bool = True) -> str:
+    """Record as a line, like dictionary.decode_line() compact color marks become ANSI escapes or are removed."""
+    entry = trace_hash_map.get(record.id)
+    if record.text is not None:
+        line = format_trace(record.text, record.args)
+    elif entry is None:
+        line = " ".join([record.id] + [str(x) for x in record.args])
+    else:
+        line = format_trace(entry.text, record.args, entry.segments)
+    return f"{record.timestamp} {render_colors(line, color)}"
+
+
+class ArchiveReader:
+    def __init__(self, path: Path, trace_hash_map: Optional[dict[str, TraceEntry]] = None):
+        self.trace_hash_map = trace_hash_map or {}
+        self._file = open(path, "rb")
+        self._data = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, version, id_size, self.chunk_size, _ = FILE_HEADER.unpack_from(self._data, 0)
+        if magic != FILE_MAGIC or version != FORMAT_VERSION or id_size != 16:
+            raise ValueError(f"{path} is not a supported trace archive")
+
+        index_offset, chunk_count, magic = TRAILER.unpack_from(self._data, len(self._data) - TRAILER.size)
+        if magic == TRAILER_MAGIC:
+            self.chunks = [Chunk(*INDEX_ENTRY.unpack_from(self._data, index_offset + i * INDEX_ENTRY.size)) for i in range(chunk_count)]
+        else:
+            # Writer was not closed, recover chunks from their sync markers
+            self.chunks = list(scan_chunks(self._data, self.chunk_size, FILE_HEADER.size, len(self._data)))
+
+    def close(self):
+        self._data.close()
+        self._file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def may_contain(self, chunk: Chunk, trace_id: bytes) -> bool:
+        _, data_size, _, _ = CHUNK_HEADER.unpack_from(self._data, chunk.offset)
+        bloom = chunk.offset + CHUNK_HEADER.size + data_size + FOOTER_TIME_RANGE.size
+        return all(self._data[bloom + bit // 8] & (1 << (bit % 8)) for bit in bloom_bits(trace_id))
+
+    def id_counts(self, chunk: Chunk) -> dict[str, int]:
+        _, data_size, _, _ = CHUNK_HEADER.unpack_from(self._data, chunk.offset)
+        offset = chunk.offset + CHUNK_HEADER.size + data_size + FOOTER_TIME_RANGE.size + BLOOM_FILTER_BITS // 8
+        (count,) = struct.unpack_from("<I", self._data, offset)
+        offset += 4
+        counts = {}
+        for _ in range(count):
+            trace_id, records = struct.unpack_from("<16sI", self._data, offset)
+            counts[trace_id.hex()] = records
+            offset += 20
+        return counts
+
+    def select(self, trace_id: Optional[str] = None, begin: Optional[int] = None, end: Optional[int] = None) -> Iterator[Chunk]:
+        return self.select_any([trace_id] if trace_id else None, begin, end)
+
+    def select_any(self, trace_ids: Optional[Collection[str]], begin: Optional[int] = None, end: Optional[int] = None) -> Iterator[Chunk]:
+        """Every chunk which may hold one of trace_ids, once. More than MAX_BLOOM_IDS IDs select by time only."""
+        raw_ids = [bytes.fromhex(x) for x in trace_ids] if trace_ids and len(trace_ids) <= MAX_BLOOM_IDS else []
+        for chunk in self.chunks:
+            if begin is not None and chunk.end < begin:
+                continue
+            if end is not None and chunk.begin > end:
+                continue
+            if raw_ids and not any(self.may_contain(chunk, x) for x in raw_ids):
+                continue
+            yield chunk
+
+    def chunk_records(self, chunk: Chunk) -> Iterator[Record]:
+        magic, data_size, _, _ = CHUNK_HEADER.unpack_from(self._data, chunk.offset)
+        if magic != CHUNK_MAGIC:
+            raise ValueError(f"Broken chunk at offset {chunk.offset}")
+        start = chunk.offset + CHUNK_HEADER.size
+        yield from decode_records(self._data, start, start + data_size, self.trace_hash_map)
+
+    def records(self, trace_id: Optional[str] = None, begin: Optional[int] = None, end: Optional[int] = None) -> Iterator[Record]:
+        for chunk in self.select(trace_id, begin, end):
+            for record in self.chunk_records(chunk):
+                if trace_id is not None and record.id != trace_id:
+                    continue
+                if begin is not None and record.timestamp < begin:
+                    continue
+                if end is not None and record.timestamp > end:
+                    continue
+                yield record
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Trace archive reader")
+    parser.add_argument("archive", type=Path, help="Path to archive file")
+    parser.add_argument("csv", type=Path, help="Path to csv file")
+    parser.add_argument("--id", type=str, default=None, help="Print only records with this trace ID")
+    parser.add_argument("--begin", type=int, default=None, help="Skip records older than this timestamp")
+    parser.add_argument("--end", type=int, default=None, help="Skip records newer than this timestamp")
+
+    args = parser.parse_args()
+
+    trace_hash_map = load_trace_map(args.csv.expanduser().resolve())
+
+    with ArchiveReader(args.archive.expanduser().resolve(), trace_hash_map) as archive:
+        for record in archive.records(args.id, args.begin, args.end):
+            print(format_record(record, trace_hash_map))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,261 @@
+"""
+Compiled dictionary, trace.tdict:
+
+    header    magic, version, ID size, entry count, bucket count and the offsets of the sections below
+    buckets   u32 per bucket, a seed for slot_hash() or a direct slot when DIRECT_SLOT is set
+    entries   one per slot: ID, text and signature in the string blob, first format segment
+    segments  per entry the literal runs between argument marks, parsed like tracing::Printer does
+    strings   every text, UTF-8, followed by its signature; sizes and segment offsets count bytes
+
+Lookups hash the ID into a bucket, the bucket seed into the slot, and compare the stored ID once.
+"""
+
+import mmap
+import os
+import struct
+from collections.abc import Mapping
+from pathlib import Path
+from typing import Iterator, Optional
+
+from dictionary import TraceEntry
+
+DICTIONARY_MAGIC = 0x43494454
+DICTIONARY_VERSION = 1
+ID_SIZE = 16
+
+DICTIONARY_HEADER = struct.Struct("<IHHIIIIII")
+BUCKET = struct.Struct("<I")
+ENTRY = struct.Struct("<16sIHBBI")
+SEGMENT = struct.Struct("<HHH")
+
+# Must match tracing::Dictionary
+DIRECT_SLOT = 0x80000000
+KEYS_PER_BUCKET = 2
+NO_ARGUMENT = 0xFFFF
+
+MASK64 = (1 << 64) - 1
+
+
+def split_id(trace_id: str) -> tuple[int, int]:
+    return int(trace_id[:16], 16), int(trace_id[16:32], 16)
+
+
+def slot_hash(key: int, seed: int) -> int:
+    x = (key ^ (seed * 0x9E3779B97F4A7C15)) & MASK64
+    x = ((x ^ (x >> 31)) * 0xBF58476D1CE4E5B9) & MASK64
+    return x ^ (x >> 29)
+
+
+def bucket_count(entries: int) -> int:
+    return max(1, (entries + KEYS_PER_BUCKET - 1) // KEYS_PER_BUCKET)
+
+
+def build_slots(ids: list[str]) -> tuple[list[int], list[int]]:
+    """
+    Hash and displace: buckets are placed largest first, each searching for a seed which puts all its IDs
+    in free slots. Buckets with a single ID take any free slot directly, which keeps the table minimal.
+    Returns the bucket table and the ID index stored in each slot.
+    """
+    buckets = bucket_count(len(ids))
+    members = [[] for _ in range(buckets)]
+    for index, trace_id in enumerate(ids):
+        high, low = split_id(trace_id)
+        members[high % buckets].append((index, low))
+
+    table = [0] * buckets
+    slots = [-1] * len(ids)
+    free = None
+    for bucket in sorted(range(buckets), key=lambda x: -len(members[x])):
+        keys = members[bucket]
+        if not keys:
+            break
+        if len(keys) == 1:
+            # Only single buckets are left, they fill the remaining slots in order
+            free = free or free_slots(slots)
+            slot = next(free)
+            slots[slot] = keys[0][0]
+            table[bucket] = DIRECT_SLOT | slot
+            continue
+        seed = 0
+        while True:
+            placed = []
+            for _, low in keys:
+                slot = slot_hash(low, seed) % len(ids)
+                if slots[slot] != -1 or slot in placed:
+                    break
+                placed.append(slot)
+            if len(placed) == len(keys):
+                break
+            seed += 1
+            if seed >= DIRECT_SLOT:
+                raise ValueError("No perfect hash seed found")
+        for (index, _), slot in zip(keys, placed):
+            slots[slot] = index
+        table[bucket] = seed
+    return table, slots
+
+
+def free_slots(slots: list[int]) -> Iterator[int]:
+    return (x for x, index in enumerate(slots) if index == -1)
+
+
+def parse_segments(text: bytes) -> list[tuple[int, int, int]]:
+    """Literal runs of the encoded text, each followed by an argument mark "{}" or "{:spec}" unless it is the last one."""
+    segments = []
+    start = 0
+    offset = 0
+    while True:
+        mark = text.find(b"{", offset)
+        if mark == -1:
+            segments.append((start, len(text) - start, NO_ARGUMENT))
+            return segments
+        end = text.find(b"}", mark)
+        if end == -1 or (end != mark + 1 and text[mark + 1] != ord(":")):
+            offset = mark + 1
+            continue
+        segments.append((start, mark - start, end - mark - 1))
+        start = offset = end + 1
+
+
+def write_dictionary(path: Path, rows: list[tuple[str, str, str]]):
+    """rows hold unique (ID, text, signature) tuples, like trace.csv."""
+    table, slots = build_slots([row[0] for row in rows])
+
+    strings = bytearray()
+    entries = bytearray()
+    segments = bytearray()
+    segment_count = 0
+    for index in slots:
+        trace_id, text, signature = rows[index]
+        encoded = text.encode("utf-8")
+        parsed = parse_segments(encoded)
+        if len(encoded) > 0xFFFE or len(signature) > 0xFF or len(parsed) > 0xFF:
+            raise ValueError(f"Trace '{text}' is too long for the binary dictionary")
+        entries += ENTRY.pack(bytes.fromhex(trace_id), len(strings), len(encoded), len(signature), len(parsed), segment_count)
+        for segment in parsed:
+            segments += SEGMENT.pack(*segment)
+        segment_count += len(parsed)
+        strings += encoded + signature.encode("ascii")
+
+    buckets_offset = DICTIONARY_HEADER.size
+    entries_offset = buckets_offset + len(table) * BUCKET.size
+    segments_offset = entries_offset + len(entries)
+    strings_offset = segments_offset + len(segments)
+    header = DICTIONARY_HEADER.pack(
+        DICTIONARY_MAGIC,
+        DICTIONARY_VERSION,
+        ID_SIZE,
+        len(rows),
+        len(table),
+        buckets_offset,
+        entries_offset,
+        segments_offset,
+        strings_offset,
+    )
+    # Readers map the file, it is replaced as a whole and never rewritten under them
+    temporary = path.with_name(path.name + ".tmp")
+    with open(temporary, "wb") as file:
+        file.write(header)
+        file.write(b"".join(BUCKET.pack(x) for x in table))
+        file.write(entries)
+        file.write(segments)
+        file.write(strings)
+    os.replace(temporary, path)
+
+
+def write_cpp_dictionary(path: Path, rows: list[tuple[str, str, str]]):
+    """Same table as constexpr tracing::Dictionary data, texts are copied from the sources still escaped."""
+    table, slots = build_slots([row[0] for row in rows])
+    guard = "TRACE_DICTIONARY_H"
+    with open(path, "w") as file:
+        file.write(f"// Generated by hash_map_gen.py, do not edit\n#ifndef {guard}\n#define {guard}\n\n")
+        file.write('#include "tracing/dictionary.h"\n\nnamespace tracing::generated {\n\n')
+        file.write(f"inline constexpr std::array<uint32_t, {len(table)}> TraceDictionaryBuckets = {{\n")
+        file.write("".join(f"  0x{x:08x},\n" for x in table))
+        file.write("};\n\n")
+        file.write(f"inline constexpr std::array<DictionaryEntry, {len(slots)}> TraceDictionaryEntries = {{ {{\n")
+        file.write("".join('  {{ "{}", "{}", "{}" }},\n'.format(*rows[index]) for index in slots))
+        file.write("} };\n\n")
+        file.write("inline constexpr Dictionary TraceDictionary(TraceDictionaryBuckets, TraceDictionaryEntries);\n\n")
+        file.write(f"}}\n\n#endif /* {guard} */\n")
+
+
+def is_binary_dictionary(path: Path) -> bool:
+    with open(path, "rb") as file:
+        magic = file.read(BUCKET.size)
+    return len(magic) == BUCKET.size and BUCKET.unpack(magic)[0] == DICTIONARY_MAGIC
+
+
+class BinaryDictionary(Mapping):
+    """Read-only trace map over a mapped trace.tdict, entries are decoded on first lookup only."""
+
+    def __init__(self, path: Path):
+        self._file = open(path, "rb")
+        self._data = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        magic, version, id_size, self._count, self._buckets, *offsets = DICTIONARY_HEADER.unpack_from(self._data, 0)
+        if magic != DICTIONARY_MAGIC or version != DICTIONARY_VERSION or id_size != ID_SIZE:
+            raise ValueError(f"{path} is not a supported binary dictionary")
+        self._buckets_offset, self._entries_offset, self._segments_offset, self._strings_offset = offsets
+        self._cache = {}
+
+    def close(self):
+        self._data.close()
+        self._file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def slot(self, trace_id: str) -> Optional[int]:
+        if self._count == 0 or len(trace_id) != ID_SIZE * 2:
+            return None
+        try:
+            high, low = split_id(trace_id)
+        except ValueError:
+            return None
+        (value,) = BUCKET.unpack_from(self._data, self._buckets_offset + (high % self._buckets) * BUCKET.size)
+        slot = value & ~DIRECT_SLOT if value & DIRECT_SLOT else slot_hash(low, value) % self._count
+        offset = self._entries_offset + slot * ENTRY.size
+        if self._data[offset : offset + ID_SIZE] != bytes.fromhex(trace_id):
+            return None
+        return slot
+
+    def entry(self, slot: int) -> tuple:
+        return ENTRY.unpack_from(self._data, self._entries_offset + slot * ENTRY.size)
+
+    def __getitem__(self, trace_id: str) -> TraceEntry:
+        cached = self._cache.get(trace_id)
+        if cached is not None:
+            return cached
+        slot = self.slot(trace_id) if isinstance(trace_id, str) else None
+        if slot is None:
+            raise KeyError(trace_id)
+        _, text_offset, text_size, signature_size, count, first = self.entry(slot)
+        start = self._strings_offset + text_offset
+        encoded = self._data[start : start + text_size]
+        signature = self._data[start + text_size : start + text_size + signature_size].decode("ascii")
+        entry = TraceEntry(encoded.decode("utf-8"), signature, self.read_segments(encoded, count, first))
+        self._cache[trace_id] = entry
+        return entry
+
+    def __iter__(self) -> Iterator[str]:
+        for slot in range(self._count):
+            yield self.entry(slot)[0].hex()
+
+    def __len__(self) -> int:
+        return self._count
+
+    def segments(self, trace_id: str) -> list[tuple[str, Optional[str]]]:
+        return self[trace_id].segments
+
+    def read_segments(self, text: bytes, count: int, first: int) -> list[tuple[str, Optional[str]]]:
+        """Pre-parsed format of a trace: literal runs, each with the argument format spec which follows it."""
+        output = []
+        for i in range(count):
+            start, size, spec = SEGMENT.unpack_from(self._data, self._segments_offset + (first + i) * SEGMENT.size)
+            mark = start + size + 1
+            literal = text[start : start + size].decode("utf-8")
+            output.append((literal, None if spec == NO_ARGUMENT else text[mark : mark + spec].decode("utf-8")))
+        return output
@@ -0,0 +1,110 @@
+import argparse
+import json
+import sys
+from pathlib import Path
+from typing import Iterator, Optional, TextIO
+
+from archive import ArchiveReader
+from dictionary import SPAN_BEGIN, TraceEntry, format_trace, is_span, load_trace_map, parse_arguments, render_colors
+from parallel_decode import is_archive
+from query import TIME_UNITS
+
+# Chrome Trace Event timestamps are microseconds
+MICROSECONDS = 1_000_000
+
+
+def event_name(text: str, args: list) -> str:
+    # Viewers show names as they are, compact color marks and ANSI escapes are removed
+    return render_colors(format_trace(text, args), False)
+
+
+class Exporter:
+    """Chrome Trace Event JSON (also read by Perfetto) from span records, tracing::Span."""
+
+    def __init__(self, output: TextIO, time_unit: str, pid: int):
+        self.output = output
+        self.scale = MICROSECONDS / TIME_UNITS[time_unit]
+        self.pid = pid
+        self.events = 0
+
+    def __enter__(self):
+        self.output.write('{"displayTimeUnit": "ns", "traceEvents": [\n')
+        return self
+
+    def __exit__(self, *args):
+        self.output.write("\n]}\n")
+
+    def write(self, event: dict):
+        # Events are streamed, large captures never build the whole list in memory
+        if self.events:
+            self.output.write(",\n")
+        self.output.write(json.dumps(event))
+        self.events += 1
+
+    def span(self, text: str, args: list):
+        timestamp, thread, args = args[0], args[1], args[2:]
+        event = {"name": event_name(text[2:], args), "ph": "B" if text.startswith(SPAN_BEGIN) else "E"}
+        event.update({"ts": timestamp * self.scale, "pid": self.pid, "tid": thread})
+        if args:
+            event["args"] = {f"arg{i}": x for i, x in enumerate(args)}
+        self.write(event)
+
+    def instant(self, text: str, args: list, timestamp: int):
+        self.write({"name": event_name(text, args), "ph": "i", "s": "g", "ts": timestamp * self.scale, "pid": self.pid, "tid": 0})
+
+
+def text_spans(path: Path, trace_hash_map: dict[str, TraceEntry]) -> Iterator[tuple[str, list]]:
+    with open(path, "r", errors="replace") as file:
+        for line in file:
+            entry = trace_hash_map.get(line[:32])
+            if entry is None:
+                continue
+            args = parse_arguments(line.rstrip("\n").split(" ")[1:], entry.signature)
+            if is_span(entry.text, args):
+                yield entry.text, args
+
+
+def export(capture: Path, trace_hash_map: dict[str, TraceEntry], exporter: Exporter, instants: bool):
+    if not is_archive(capture):
+        for text, args in text_spans(capture, trace_hash_map):
+            exporter.span(text, args)
+        return
+
+    with ArchiveReader(capture, trace_hash_map) as archive:
+        for record in archive.records():
+            entry = trace_hash_map.get(record.id)
+            text: Optional[str] = record.text if record.text is not None else entry.text if entry else None
+            if text is None:
+                continue
+            if is_span(text, record.args):
+                exporter.span(text, record.args)
+            elif instants:
+                # Point traces carry the archive timestamp, it must come from the same clock as tracing::SpanClock
+                exporter.instant(text, record.args, record.timestamp)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Export trace spans as Chrome Trace Event JSON for chrome://tracing and Perfetto")
+    parser.add_argument("capture", type=Path, help="Path to text capture or trace archive")
+    parser.add_argument("csv", type=Path, help="Path to csv file")
+    parser.add_argument("-o", "--output", type=Path, default=None, help="Output JSON file, stdout when missing")
+    parser.add_argument("--time-unit", type=str, choices=TIME_UNITS, default="ns", help="Span timestamp unit")
+    parser.add_argument("--pid", type=int, default=1, help="Process ID shown in the viewer")
+    parser.add_argument("--instants", action="store_true", help="Add archive point traces as instant events")
+
+    args = parser.parse_args()
+
+    capture = args.capture.expanduser().resolve()
+    trace_hash_map = load_trace_map(args.csv.expanduser().resolve())
+
+    output = open(args.output.expanduser().resolve(), "w") if args.output else sys.stdout
+    try:
+        with Exporter(output, args.time_unit, args.pid) as exporter:
+            export(capture, trace_hash_map, exporter, args.instants)
+    finally:
+        if args.output:
+            output.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,204 @@
+import csv
+import re
+import zlib
+from collections.abc import Mapping
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Optional
+
+INTERN_DEFINITION_PATTERN = r"^@([0-9a-f]{8})=(.*)$"
+INTERN_ID_LENGTH = 9
+SPAN_BEGIN = "B:"
+SPAN_END = "F:"
+HIT_COUNT_PATTERN = r"^%([0-9a-f]{32}) ([0-9a-f]+)$"
+STREAM_HEADER_PATTERN = rb"^~T(\d+) id=(\d+) hash=(\w+) endian=(le|be) build=([0-9A-Za-z._-]*)$"
+SYNC_PATTERN = rb"^~S([0-9a-f]{8}) ([0-9a-f]{8})$"
+STREAM_VERSION = 1
+# tracing::Printer::Profile::Compact, the byte after the mark is the SGR code
+COMPACT_COLOR_PATTERN = re.compile("\x1a(.)", re.DOTALL)
+ANSI_COLOR_PATTERN = re.compile("\x1b\\[\\d+m")
+# An argument mark with the space before it, span end records are printed without arguments
+ARGUMENT_MARK_PATTERN = re.compile(r" ?\{(:[^{}]*)?\}")
+DICTIONARY_NAMES = ("trace.tdict", "trace.csv")
+
+
+@dataclass
+class TraceEntry:
+    text: str
+    signature: str = ""
+    # Literal runs and argument format specs of text, held by a compiled trace.tdict only
+    segments: Optional[list[tuple[str, Optional[str]]]] = None
+
+
+def load_trace_map(path: Path) -> Mapping[str, TraceEntry]:
+    """trace.csv is parsed into a dict, a compiled trace.tdict is mapped and used as it is."""
+    from binary_dictionary import BinaryDictionary, is_binary_dictionary
+
+    if is_binary_dictionary(path):
+        return BinaryDictionary(path)
+    trace_hash_map = {}
+    with open(path, mode="r") as file:
+        csvfile = csv.reader(file, delimiter=";")
+        for line in csvfile:
+            trace_hash_map.update({line[0]: TraceEntry(*line[1:3])})
+    return trace_hash_map
+
+
+@dataclass
+class StreamHeader:
+    version: int
+    id_width: int
+    hash: str
+    endian: str
+    build: str
+
+
+class SyncChecker:
+    """
+    Follows the stream control lines of tracing::Printer: the header and the sync markers closing every block
+    with the CRC-32 of its lines. Until the first of them is seen (joining mid-stream) nothing can be checked.
+    """
+
+    def __init__(self, synced: bool = False):
+        self.synced = synced
+        self.crc = 0
+        self.sequence = None
+        self.header = None
+
+    def feed(self, line: bytes) -> tuple[bool, Optional[str]]:
+        """Returns whether the line (without its newline) is a control line, and a message when a check fails."""
+        header = re.match(STREAM_HEADER_PATTERN, line) if line.startswith(b"~T") else None
+        sync = re.match(SYNC_PATTERN, line) if line.startswith(b"~S") else None
+        if not header and not sync:
+            if self.synced:
+                self.crc = zlib.crc32(b"\n", zlib.crc32(line, self.crc))
+            return False, None
+
+        if header:
+            self.header = StreamHeader(int(header[1]), int(header[2]), header[3].decode(), header[4].decode(), header[5].decode())
+            self.start(-1)
+            if self.header.version != STREAM_VERSION or self.header.id_width != 32 or self.header.hash != "md5":
+                return True, f"# unsupported stream header {line.decode()}"
+            return True, None
+
+        sequence, crc = int(sync[1], 16), int(sync[2], 16)
+        message = None
+        if self.synced and crc != self.crc:
+            message = f"# sync {sequence:x}: CRC mismatch, lines since the previous marker are corrupt"
+        elif self.sequence is not None and sequence != self.sequence + 1:
+            message = f"# sync {sequence:x}: expected {self.sequence + 1:x}, blocks are missing"
+        self.start(sequence)
+        return True, message
+
+    def start(self, sequence: int):
+        self.synced = True
+        self.crc = 0
+        self.sequence = sequence
+
+
+def resolve_dictionary(path: Path, build: str) -> Optional[Path]:
+    """A dictionary directory holds one subdirectory per build ID, see hash_map_gen.py --build-id."""
+    for name in DICTIONARY_NAMES:
+        candidate = path / build / name
+        if build and candidate.is_file():
+            return candidate
+    return None
+
+
+def read_stream_header(path: Path) -> Optional[StreamHeader]:
+    checker = SyncChecker()
+    with open(path, "rb") as file:
+        checker.feed(file.readline().rstrip(b"\n"))
+    return checker.header
+
+
+def render_colors(line: str, ansi: bool) -> str:
+    """Compact color marks become ANSI escapes for terminals, otherwise every color is removed."""
+    if "\x1a" not in line and (ansi or "\x1b" not in line):
+        return line
+    if ansi:
+        return COMPACT_COLOR_PATTERN.sub(lambda x: f"\x1b[{ord(x[1])}m", line)
+    return ANSI_COLOR_PATTERN.sub("", COMPACT_COLOR_PATTERN.sub("", line))
+
+
+def is_span(text: str, args: list) -> bool:
+    return text[:2] in (SPAN_BEGIN, SPAN_END) and len(args) >= 2
+
+
+def format_trace(text: str, args: list, segments: Optional[list[tuple[str, Optional[str]]]] = None) -> str:
+    """segments are the pre-parsed text of a compiled dictionary entry, the text is parsed again without them."""
+    if is_span(text, args):
+        # Span records lead with the timestamp and the thread ID, tracing::Span
+        if text[:2] == SPAN_END:
+            return f"{ARGUMENT_MARK_PATTERN.sub('', text)} ts={args[0]} thread={args[1]}"
+        return f"{format_trace(text, args[2:], segments)} ts={args[0]} thread={args[1]}"
+    if not args:
+        return text
+    # Byte blobs print as a hex dump and bools in lower case, like tracing::Printer does
+    args = [x.hex() if isinstance(x, bytes) else str(x).lower() if isinstance(x, bool) else x for x in args]
+    if segments is None:
+        return text.format(*args)
+    output = []
+    for i, (literal, spec) in enumerate(segments):
+        output.append(literal)
+        if spec is not None:
+            output.append(format(args[i], spec[1:]))
+    return "".join(output)
+
+
+def parse_hex(token: str):
+    """
+    Untyped trailing arguments are hex integers, floating point ones are hex floats. Anything else, e.g. a string,
+    is kept as printed. Byte blobs cannot be told from integers, tracing::Printer takes them in typed traces only.
+    """
+    try:
+        return int(token, 16)
+    except ValueError:
+        pass
+    try:
+        return float.fromhex(token)
+    except ValueError:
+        return token
+
+
+def parse_arguments(tokens: list[str], signature: str) -> list:
+    if not signature:
+        return [parse_hex(x) for x in tokens]
+    args = []
+    for i, code in enumerate(signature):
+        if code == "s":
+            # Strings may hold spaces, only the last one can be recovered completely
+            args.append(" ".join(tokens[i:]) if i == len(signature) - 1 else tokens[i])
+        elif code == "?":
+            args.append(tokens[i] == "true")
+        elif code in ("f", "d"):
+            args.append(float.fromhex(tokens[i]))
+        elif code == "y":
+            args.append(bytes.fromhex(tokens[i]))
+        else:
+            args.append(int(tokens[i], 16))
+    return args
+
+
+def decode_line(
+    line: str, trace_hash_map: dict[str, TraceEntry], interned: Optional[dict[str, str]] = None, color: bool = True
+) -> Optional[str]:
+    """Decode one text line, interned definitions are stored in interned and give None. Colors go through render_colors()."""
+    if interned is not None and line.startswith("@"):
+        definition = re.match(INTERN_DEFINITION_PATTERN, line)
+        if definition:
+            interned[definition[1]] = definition[2]
+            return None
+        if line[1:INTERN_ID_LENGTH] in interned:
+            return render_colors(format_trace(interned[line[1:INTERN_ID_LENGTH]], [int(x, 16) for x in line.split(" ")[1:]]), color)
+    hit_count = re.match(HIT_COUNT_PATTERN, line)
+    if hit_count:
+        # tracing::HitCounters dump
+        entry = trace_hash_map.get(hit_count[1])
+        return f"{int(hit_count[2], 16)} hits {entry.text if entry else hit_count[1]}"
+    if len(line) >= 32 and (len(line) == 32 or line[32] == " "):
+        if line[:32] in trace_hash_map:
+            splited = line.split(" ")
+            entry = trace_hash_map[line[:32]]
+            line = format_trace(entry.text, parse_arguments(splited[1:], entry.signature), entry.segments)
+    return render_colors(line, color)
@@ -1,11 +1,56 @@
 import argparse
 import csv
 import hashlib
+import os
 import re
 from pathlib import Path
 
+from binary_dictionary import write_cpp_dictionary, write_dictionary
+
 TRACING_SOURCE_FILES = (".cpp", ".h")
-TRACING_PATTERN = r'HashTrace::(.*)[ ]*?\([ ]*?"(.*)"'
+# Argument types may hold one level of template arguments, e.g. std::span<const std::byte>
+TYPE_LIST = r"(?:[^<>]|<[^<>]*>)*"
+TRACING_PATTERN = r'HashTrace::(\w+)[ ]*?(?:<(' + TYPE_LIST + r')>)?[ ]*?\([ ]*?"((?:[^"\\]|\\.)*)"'
+TRACING_TEMPLATE_PATTERN = r'HashTrace::(\w+)[ ]*?<[ ]*?"((?:[^"\\]|\\.)*)"[ ]*?(?:,(' + TYPE_LIST + r'))?>'
+
+# Must match tracing::TypeCode. Types whose width or signedness depends on the target come from get_type_codes().
+TYPE_CODES = {
+    "bool": "?",
+    "signed char": "b",
+    "int8_t": "b",
+    "unsigned char": "B",
+    "uint8_t": "B",
+    "short": "h",
+    "int16_t": "h",
+    "unsigned short": "H",
+    "uint16_t": "H",
+    "int": "i",
+    "int32_t": "i",
+    "unsigned": "I",
+    "unsigned int": "I",
+    "uint32_t": "I",
+    "long long": "q",
+    "int64_t": "q",
+    "unsigned long long": "Q",
+    "uint64_t": "Q",
+    "float": "f",
+    "double": "d",
+    "char*": "s",
+    "const char*": "s",
+    "string_view": "s",
+    "span<const byte>": "y",
+    "span<byte>": "y",
+}
+
+# Codes of long, unsigned long and size_t per data model, the signature changes with the target
+DATA_MODELS = {
+    "LP64": ("q", "Q", "Q"),
+    "LLP64": ("i", "I", "Q"),
+    "ILP32": ("i", "I", "I"),
+}
+DEFAULT_DATA_MODEL = "LP64"
+
+SPAN_LEVELS = ("B:", "F:")
 
 
 def get_level_str(level: str) -> str:
@@ -19,50 +64,108 @@ def get_level_str(level: str) -> str:
         return ""
 
 
+def get_level_strs(level: str) -> tuple[str, ...]:
+    # Spans hash a begin and an end ID, tracing::HashTrace::span
+    if level == "span":
+        return SPAN_LEVELS
+    return (get_level_str(level),)
+
+
+def get_type_codes(data_model: str, unsigned_char: bool) -> dict[str, str]:
+    long_code, unsigned_long_code, size_code = DATA_MODELS[data_model]
+    target_types = {
+        "char": "B" if unsigned_char else "b",
+        "long": long_code,
+        "unsigned long": unsigned_long_code,
+        "size_t": size_code,
+    }
+    return TYPE_CODES | target_types
+
+
+def get_signature(types: str, type_codes: dict[str, str]) -> str:
+    signature = ""
+    for name in types.split(",") if types.strip() else []:
+        name = " ".join(name.replace("std::", "").replace("*", " *").split()).replace(" *", "*")
+        if name in type_codes:
+            signature += type_codes[name]
+        elif name.endswith("*"):
+            # Any other pointer, tracing::isDataPointer
+            signature += "P"
+        else:
+            raise ValueError(f"Unsupported trace argument type '{name}'")
+    return signature
+
+
 def get_hash(text: str) -> str:
-    return hashlib.md5(text.encode("ascii")).hexdigest()
+    # Sources are UTF-8, tracing::hashing() runs over the bytes of the literal
+    return hashlib.md5(text.encode("utf-8")).hexdigest()
 
 
-def get_hash_map_from_trace_list(trace_list: list[tuple[str, str]]) -> list[tuple[str, str]]:
+def get_hash_map_from_trace_list(trace_list: list[tuple[str, str, str]], type_codes: dict[str, str]) -> list[tuple[str, str, str]]:
     output = []
     for trace in trace_list:
-        level, text = trace
-        text = get_level_str(level) + text
-        hash = (get_hash(text), text)
-        output.append(hash)
+        level, types, text = trace
+        signature = get_signature(types, type_codes)
+        for level_str in get_level_strs(level):
+            hashed = level_str + text + "\0" + signature if signature else level_str + text
+            hash = (get_hash(hashed), level_str + text, signature)
+            output.append(hash)
     return output
 
 
-def get_hash_map(directory: Path, source_files: str) -> list[tuple[str, str]]:
+def get_hash_map(directory: Path, source_files: str, type_codes: dict[str, str]) -> list[tuple[str, str, str]]:
     trace_list = []
     for source in directory.glob("**/*" + source_files):
         with open(source, "r") as file:
-            trace = re.findall(TRACING_PATTERN, file.read(), re.MULTILINE)
-            if trace:
-                trace_list += trace
+            content = file.read()
+            trace_list += re.findall(TRACING_PATTERN, content, re.MULTILINE)
+            trace_list += [(level, types, text) for level, text, types in re.findall(TRACING_TEMPLATE_PATTERN, content, re.MULTILINE)]
 
-    return get_hash_map_from_trace_list(trace_list)
+    return get_hash_map_from_trace_list(trace_list, type_codes)
 
 
 def main():
     parser = argparse.ArgumentParser(description="Generate Tracing Hash Map")
     parser.add_argument("root", type=Path, help="Root directory")
     parser.add_argument("output", type=Path, help="Output directory")
+    parser.add_argument("--binary", action="store_true", help="Also write the compiled dictionary trace.tdict")
+    parser.add_argument("--cpp", action="store_true", help="Also write trace_dictionary.h, a constexpr tracing::Dictionary")
+    parser.add_argument("--build-id", type=str, default=None, help="Write into <output>/<build ID>, decoders pick it by the stream header")
+    parser.add_argument(
+        "--data-model", type=str, choices=tuple(DATA_MODELS), default=DEFAULT_DATA_MODEL, help="Target widths of long and size_t"
+    )
+    parser.add_argument("--unsigned-char", action="store_true", help="Target char is unsigned, e.g. ARM and RISC-V")
 
     args = parser.parse_args()
 
     root = args.root.expanduser().resolve()
     output = args.output.expanduser().resolve()
+    if args.build_id:
+        if not re.fullmatch(r"[0-9A-Za-z._-]+", args.build_id):
+            parser.error("Build ID may hold letters, digits, '.', '_' and '-' only")
+        output = output / args.build_id
+        output.mkdir(parents=True, exist_ok=True)
 
+    type_codes = get_type_codes(args.data_model, args.unsigned_char)
     hash_map = []
     for source_files in TRACING_SOURCE_FILES:
-        hash_map += get_hash_map(root, source_files)
+        hash_map += get_hash_map(root, source_files, type_codes)
 
     # TODO detect collisions
-    with open(output / "trace.csv", "w", newline="") as csvfile:
+    # Running decoders reload the dictionary, it is replaced as a whole and never seen half written
+    temporary = output / "trace.csv.tmp"
+    with open(temporary, "w", newline="") as csvfile:
         spamwriter = csv.writer(csvfile, delimiter=";")
         for hash in hash_map:
             spamwriter.writerow(hash)
+    os.replace(temporary, output / "trace.csv")
+
+    # Traces used at several places hash to the same row, perfect hashing needs every ID once
+    unique = list({hash[0]: hash for hash in hash_map}.values())
+    if args.binary:
+        write_dictionary(output / "trace.tdict", unique)
+    if args.cpp:
+        write_cpp_dictionary(output / "trace_dictionary.h", unique)
 
 
 if __name__ == "__main__":
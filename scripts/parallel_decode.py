@@ -0,0 +1,198 @@
+import argparse
+import mmap
+import os
+import re
+import sys
+from collections import deque
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+from typing import Iterator
+
+from archive import CHUNK_HEADER, FILE_HEADER, FILE_MAGIC, ArchiveReader, Chunk, decode_records, format_record
+from dictionary import (
+    INTERN_DEFINITION_PATTERN,
+    SYNC_PATTERN,
+    SyncChecker,
+    TraceEntry,
+    decode_line,
+    load_trace_map,
+    read_stream_header,
+    resolve_dictionary,
+)
+
+TASKS_PER_WORKER = 8
+MIN_TASK_SIZE = 1024 * 1024
+SYNC_SEARCH_SIZE = MIN_TASK_SIZE
+
+trace_hash_map: dict[str, TraceEntry] = {}
+
+
+def init_worker(tracecsv: Path):
+    global trace_hash_map
+    trace_hash_map = load_trace_map(tracecsv)
+
+
+def open_capture(path: Path) -> tuple:
+    file = open(path, "rb")
+    return file, mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ)
+
+
+def boundary(data, offset: int) -> tuple[int, bool]:
+    """
+    Text ranges start right after the first sync marker near their nominal start, so every block is checked by
+    the range holding it. Without a marker they start at the next line. Returns the start and whether it is synced.
+    """
+    if offset == 0 or offset >= len(data):
+        return min(offset, len(data)), False
+    marker = data.find(b"\n~S", offset - 1, offset + SYNC_SEARCH_SIZE)
+    while marker != -1:
+        end = data.find(b"\n", marker + 1)
+        end = len(data) if end == -1 else end
+        if re.match(SYNC_PATTERN, data[marker + 1 : end]):
+            return min(end + 1, len(data)), True
+        marker = data.find(b"\n~S", marker + 1, offset + SYNC_SEARCH_SIZE)
+    if data[offset - 1] == ord("\n"):
+        return offset, False
+    newline = data.find(b"\n", offset)
+    return (len(data) if newline == -1 else newline + 1), False
+
+
+def decode_text_range(path: Path, begin: int, end: int, interned: dict[str, str]) -> str:
+    """Decode every line owned by [begin, end), ranges are moved to line or sync marker boundaries."""
+    file, data = open_capture(path)
+    try:
+        begin, synced = boundary(data, begin)
+        end, _ = boundary(data, end)
+        if begin >= end:
+            return ""
+
+        checker = SyncChecker(synced)
+        output = []
+        lines = data[begin:end].split(b"\n")
+        if not lines[-1]:
+            lines.pop()
+        for line in lines:
+            control, message = checker.feed(line)
+            if message is not None:
+                output.append(message)
+            decoded = None if control else decode_line(line.decode("utf-8", errors="replace"), trace_hash_map, interned)
+            if decoded is not None:
+                output.append(decoded)
+        return "".join(line + "\n" for line in output)
+    finally:
+        data.close()
+        file.close()
+
+
+def decode_archive_chunks(path: Path, chunks: list[Chunk]) -> str:
+    file, data = open_capture(path)
+    try:
+        output = []
+        for chunk in chunks:
+            _, data_size, _, _ = CHUNK_HEADER.unpack_from(data, chunk.offset)
+            start = chunk.offset + CHUNK_HEADER.size
+            records = decode_records(data, start, start + data_size, trace_hash_map)
+            output += [format_record(record, trace_hash_map) + "\n" for record in records]
+        return "".join(output)
+    finally:
+        data.close()
+        file.close()
+
+
+def task_size(size: int, workers: int) -> int:
+    return max(MIN_TASK_SIZE, size // (workers * TASKS_PER_WORKER))
+
+
+def split_text(size: int, workers: int) -> list[tuple[int, int]]:
+    step = task_size(size, workers)
+    return [(offset, min(offset + step, size)) for offset in range(0, size, step)]
+
+
+def split_archive(chunks: list[Chunk], size: int, workers: int) -> list[list[Chunk]]:
+    step = task_size(size, workers)
+    tasks = [[]]
+    used = 0
+    for chunk in chunks:
+        if used >= step:
+            tasks.append([])
+            used = 0
+        tasks[-1].append(chunk)
+        used += chunk.size
+    return tasks
+
+
+def find_definitions(path: Path, begin: int, end: int) -> dict[str, str]:
+    """Interned text definitions of the lines owned by [begin, end), the same lines decode_text_range() decodes."""
+    file, data = open_capture(path)
+    try:
+        begin, _ = boundary(data, begin)
+        end, _ = boundary(data, end)
+        pattern = re.compile(INTERN_DEFINITION_PATTERN.encode(), re.MULTILINE)
+        return {match[1].decode(): match[2].decode("utf-8", errors="replace") for match in pattern.finditer(data, begin, end)}
+    finally:
+        data.close()
+        file.close()
+
+
+def is_archive(path: Path) -> bool:
+    with open(path, "rb") as file:
+        header = file.read(FILE_HEADER.size)
+    return len(header) == FILE_HEADER.size and FILE_HEADER.unpack(header)[0] == FILE_MAGIC
+
+
+def decode(path: Path, tracecsv: Path, workers: int) -> Iterator[str]:
+    size = path.stat().st_size
+    if size == 0:
+        return
+    with ProcessPoolExecutor(max_workers=workers, initializer=init_worker, initargs=(tracecsv,)) as executor:
+        if is_archive(path):
+            # Chunk boundaries come from the archive index, or from the chunk sync markers when the index is missing
+            with ArchiveReader(path) as archive:
+                chunks = archive.chunks
+            tasks = [(decode_archive_chunks, path, task) for task in split_archive(chunks, size, workers)]
+        else:
+            # Interned text definitions may be far from their uses, every range is scanned for them in parallel
+            # first. A range starts with the definitions of the ranges before it, like decoding in order does.
+            ranges = split_text(size, workers)
+            begins = [begin for begin, _ in ranges]
+            ends = [end for _, end in ranges]
+            definitions = {}
+            tasks = []
+            for begin, end, found in zip(begins, ends, executor.map(find_definitions, [path] * len(ranges), begins, ends)):
+                tasks.append((decode_text_range, path, begin, end, dict(definitions)))
+                definitions.update(found)
+
+        # Small tasks are pulled by idle workers from the shared queue, a bounded window keeps memory flat
+        # while results are still yielded in capture order.
+        pending = deque()
+        for task in tasks:
+            pending.append(executor.submit(*task))
+            if len(pending) >= workers * 2:
+                yield pending.popleft().result()
+        while pending:
+            yield pending.popleft().result()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Parallel trace capture decoder")
+    parser.add_argument("capture", type=Path, help="Path to text capture or trace archive")
+    parser.add_argument("csv", type=Path, help="Path to csv or tdict file, or a directory of builds")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count(), help="Number of worker processes")
+
+    args = parser.parse_args()
+
+    capture = args.capture.expanduser().resolve()
+    tracecsv = args.csv.expanduser().resolve()
+    if tracecsv.is_dir():
+        # Pick the dictionary of the build named in the stream header
+        header = None if is_archive(capture) else read_stream_header(capture)
+        tracecsv = resolve_dictionary(tracecsv, header.build) if header else None
+        if tracecsv is None:
+            parser.error("No dictionary matches the capture build ID")
+
+    for output in decode(capture, tracecsv, max(1, args.jobs)):
+        sys.stdout.write(output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,175 @@
+import argparse
+import operator
+import re
+from collections import Counter, defaultdict
+from pathlib import Path
+from typing import Callable
+
+from archive import ArchiveReader, Record
+from dictionary import TraceEntry, load_trace_map
+
+LEVELS = ("I", "W", "E")
+
+OPERATORS = {
+    "==": operator.eq,
+    "!=": operator.ne,
+    "<=": operator.le,
+    ">=": operator.ge,
+    "<": operator.lt,
+    ">": operator.gt,
+}
+
+PREDICATE_PATTERN = r"^arg(\d+)\s*(==|!=|<=|>=|<|>)\s*(.+)$"
+
+TIME_UNITS = {"ns": 1_000_000_000, "us": 1_000_000, "ms": 1_000, "s": 1}
+
+
+def parse_value(text: str):
+    if text in ("true", "false"):
+        return text == "true"
+    try:
+        return int(text, 0)
+    except ValueError:
+        pass
+    try:
+        return float(text)
+    except ValueError:
+        return text.strip("\"'")
+
+
+def parse_predicate(text: str) -> Callable[[Record], bool]:
+    match = re.match(PREDICATE_PATTERN, text.strip())
+    if not match:
+        raise argparse.ArgumentTypeError(f"Bad predicate '{text}', expected e.g. arg0>=10")
+    index, compare, value = int(match[1]), OPERATORS[match[2]], parse_value(match[3])
+
+    def predicate(record: Record) -> bool:
+        if index >= len(record.args):
+            return False
+        try:
+            return compare(record.args[index], value)
+        except TypeError:
+            return False
+
+    return predicate
+
+
+class Query:
+    def __init__(self, args: argparse.Namespace, trace_hash_map: dict[str, TraceEntry]):
+        self.trace_hash_map = trace_hash_map
+        self.begin = args.begin
+        self.end = args.end
+        self.predicates = [parse_predicate(x) for x in args.where]
+        self.group_by_id = args.group_by_id
+        self.argument = args.argument
+        self.bucket = args.bucket
+        self.rate = TIME_UNITS[args.time_unit] if args.rate else None
+
+        self.ids = set(args.id)
+        if args.level:
+            levels = {x + ":" for x in args.level}
+            by_level = {key for key, entry in trace_hash_map.items() if entry.text[:2] in levels}
+            self.ids = (self.ids & by_level) if self.ids else by_level
+
+        self.count = Counter()
+        self.minimum = {}
+        self.maximum = {}
+        self.histogram = defaultdict(Counter)
+        self.interned = {}
+
+    def needs_records(self) -> bool:
+        return bool(self.predicates) or self.argument is not None or self.rate is not None
+
+    def key(self, trace_id: str) -> str:
+        return trace_id if self.group_by_id else "*"
+
+    def accept(self, record: Record) -> bool:
+        if self.ids and record.id not in self.ids:
+            return False
+        if self.begin is not None and record.timestamp < self.begin:
+            return False
+        if self.end is not None and record.timestamp > self.end:
+            return False
+        return all(predicate(record) for predicate in self.predicates)
+
+    def add(self, record: Record):
+        key = self.key(record.id)
+        if record.text is not None:
+            self.interned[record.id] = record.text
+        self.count[key] += 1
+        if self.rate is not None:
+            self.histogram[key][record.timestamp // self.rate] += 1
+        elif self.argument is not None and self.argument < len(record.args):
+            value = record.args[self.argument]
+            # Floating point arguments aggregate like integers, bool is an int and counts as 0 or 1
+            if not isinstance(value, (int, float)):
+                return
+            if key not in self.minimum or value < self.minimum[key]:
+                self.minimum[key] = value
+            if key not in self.maximum or value > self.maximum[key]:
+                self.maximum[key] = value
+            if self.bucket:
+                self.histogram[key][value // self.bucket * self.bucket] += 1
+
+    def run(self, archive: ArchiveReader):
+        for chunk in archive.select_any(self.ids, self.begin, self.end):
+            inside = (self.begin is None or chunk.begin >= self.begin) and (self.end is None or chunk.end <= self.end)
+            if inside and self.ids and not self.needs_records():
+                # Plain counts of whole chunks come straight from the chunk footer, it holds hashed IDs only
+                for key, records in archive.id_counts(chunk).items():
+                    if key in self.ids:
+                        self.count[self.key(key)] += records
+                continue
+            for record in archive.chunk_records(chunk):
+                if self.accept(record):
+                    self.add(record)
+
+    def label(self, key: str) -> str:
+        if key == "*":
+            return "*"
+        entry = self.trace_hash_map.get(key)
+        text = entry.text if entry else self.interned.get(key)
+        return f"{key} {text}" if text is not None else key
+
+    def report(self):
+        for key in sorted(self.count, key=lambda x: -self.count[x]):
+            line = f"{self.label(key)}: count={self.count[key]}"
+            if key in self.minimum:
+                line += f" min={self.minimum[key]} max={self.maximum[key]}"
+            print(line)
+            for bucket, count in sorted(self.histogram[key].items()):
+                if self.rate is not None:
+                    print(f"  {bucket}s: {count}/s")
+                else:
+                    print(f"  [{bucket}, {bucket + self.bucket}): {count}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Trace archive query and aggregation")
+    parser.add_argument("archive", type=Path, help="Path to archive file")
+    parser.add_argument("csv", type=Path, help="Path to csv file")
+    parser.add_argument("--id", type=str, action="append", default=[], help="Select trace ID, can be repeated")
+    parser.add_argument("--level", type=str, action="append", choices=LEVELS, help="Select trace level, can be repeated")
+    parser.add_argument("--begin", type=int, default=None, help="Skip records older than this timestamp")
+    parser.add_argument("--end", type=int, default=None, help="Skip records newer than this timestamp")
+    parser.add_argument("--where", type=str, action="append", default=[], help="Argument predicate, e.g. 'arg0>=10'")
+    parser.add_argument("--group-by-id", action="store_true", help="Aggregate per trace ID")
+    parser.add_argument("--argument", type=int, default=None, help="Argument index for min/max/histogram")
+    parser.add_argument("--bucket", type=int, default=None, help="Histogram bucket width for --argument")
+    parser.add_argument("--rate", action="store_true", help="Count records per second")
+    parser.add_argument("--time-unit", type=str, choices=TIME_UNITS, default="ns", help="Timestamp unit")
+
+    args = parser.parse_args()
+
+    trace_hash_map = load_trace_map(args.csv.expanduser().resolve())
+    query = Query(args, trace_hash_map)
+    if (args.id or args.level) and not query.ids:
+        return
+
+    with ArchiveReader(args.archive.expanduser().resolve(), trace_hash_map) as archive:
+        query.run(archive)
+    query.report()
+
+
+if __name__ == "__main__":
+    main()
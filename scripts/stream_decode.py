@@ -0,0 +1,270 @@
+import argparse
+import os
+import select
+import stat
+import sys
+import time
+from pathlib import Path
+from typing import Iterator, Optional, TextIO
+
+from archive import CHUNK_HEADER, CHUNK_MAGIC, FILE_HEADER, FILE_MAGIC, FORMAT_VERSION, decode_records, format_record
+from binary_dictionary import BinaryDictionary
+from dictionary import SyncChecker, TraceEntry, decode_line, load_trace_map, resolve_dictionary
+
+READ_SIZE = 64 * 1024
+MAX_LINE_SIZE = 64 * 1024
+DEFAULT_LATENCY_MS = 10
+DEFAULT_RELOAD_MS = 1000
+FOLLOW_POLL_S = 0.05
+
+
+class DictionaryWatcher:
+    """Reloads trace.csv or trace.tdict when a new build replaces it, hash_map_gen.py swaps both in whole. Failed loads keep the old map."""
+
+    def __init__(self, path: Path, interval: float):
+        # A directory of per-build dictionaries is resolved when the stream header names the build
+        self.root = path if path.is_dir() else None
+        self.path = path
+        self.interval = interval
+        self.trace_hash_map = {} if self.root else load_trace_map(path)
+        self._stamp = self.stamp()
+        self._checked = time.monotonic()
+
+    def select_build(self, build: str) -> bool:
+        path = resolve_dictionary(self.root, build) if self.root else None
+        if path is None or path == self.path:
+            return False
+        self.path = path
+        self.replace(load_trace_map(path), self.stamp())
+        return True
+
+    def replace(self, trace_hash_map: dict[str, TraceEntry], stamp: Optional[tuple]):
+        old = self.trace_hash_map
+        self.trace_hash_map = trace_hash_map
+        self._stamp = stamp
+        if isinstance(old, BinaryDictionary):
+            # A compiled dictionary holds its file open and mapped until closed
+            old.close()
+
+    def stamp(self) -> Optional[tuple]:
+        try:
+            info = self.path.stat()
+        except OSError:
+            return None
+        return info.st_ino, info.st_mtime_ns, info.st_size
+
+    def poll(self, now: float) -> bool:
+        if now - self._checked < self.interval:
+            return False
+        self._checked = now
+        stamp = self.stamp()
+        if stamp is None or stamp == self._stamp:
+            return False
+        try:
+            trace_hash_map = load_trace_map(self.path)
+        except (OSError, TypeError, UnicodeDecodeError, ValueError):
+            return False
+        self.replace(trace_hash_map, stamp)
+        return True
+
+
+class TextDecoder:
+    """Splits the stream into lines, only the unfinished last line is kept between reads."""
+
+    def __init__(self, dictionary: DictionaryWatcher, color: bool):
+        self.dictionary = dictionary
+        self.color = color
+        self.partial = b""
+        self.interned = {}
+        self.checker = SyncChecker()
+
+    def feed(self, data: bytes, trace_hash_map: dict[str, TraceEntry]) -> Iterator[str]:
+        lines = (self.partial + data).split(b"\n")
+        self.partial = lines.pop()
+        if len(self.partial) > MAX_LINE_SIZE:
+            # Bounded memory: a runaway line is decoded in pieces
+            lines.append(self.partial)
+            self.partial = b""
+        for line in lines:
+            control, message = self.checker.feed(line)
+            if message is not None:
+                yield message
+            if control and line.startswith(b"~T"):
+                # A header starts a new stream, its runtime IDs start over
+                self.interned = {}
+                if self.dictionary.select_build(self.checker.header.build):
+                    trace_hash_map = self.dictionary.trace_hash_map
+                    print(f"# build {self.checker.header.build} uses {self.dictionary.path}", file=sys.stderr)
+            if control:
+                continue
+            decoded = decode_line(line.decode("utf-8", errors="replace"), trace_hash_map, self.interned, self.color)
+            if decoded is not None:
+                yield decoded
+
+    def finish(self, trace_hash_map: dict[str, TraceEntry]) -> Iterator[str]:
+        if self.partial:
+            yield from self.feed(b"\n", trace_hash_map)
+
+
+class ArchiveDecoder:
+    """
+    Decodes archive chunks as the writer flushes them, at most one chunk is buffered. The index and trailer
+    written at close, or garbage after a writer restart, are skipped by resyncing on the chunk marker.
+    """
+
+    def __init__(self, color: bool):
+        self.color = color
+        self.buffer = bytearray()
+        self.chunk_size = None
+        self.marker = CHUNK_MAGIC.to_bytes(4, "little")
+
+    def feed(self, data: bytes, trace_hash_map: dict[str, TraceEntry]) -> Iterator[str]:
+        self.buffer += data
+        if self.chunk_size is None:
+            if len(self.buffer) < FILE_HEADER.size:
+                return
+            magic, version, id_size, self.chunk_size, _ = FILE_HEADER.unpack_from(self.buffer, 0)
+            if magic != FILE_MAGIC or version != FORMAT_VERSION or id_size != 16:
+                raise ValueError("Stream is not a supported trace archive")
+            del self.buffer[: FILE_HEADER.size]
+
+        while len(self.buffer) >= CHUNK_HEADER.size:
+            magic, data_size, records, footer_size = CHUNK_HEADER.unpack_from(self.buffer, 0)
+            size = CHUNK_HEADER.size + data_size + footer_size
+            if magic != CHUNK_MAGIC or records == 0 or size > self.chunk_size:
+                self.resync()
+                continue
+            if len(self.buffer) < size:
+                return
+            try:
+                for record in decode_records(self.buffer, CHUNK_HEADER.size, CHUNK_HEADER.size + data_size, trace_hash_map):
+                    yield format_record(record, trace_hash_map, self.color)
+            except ValueError as error:
+                yield f"# {error}"
+            del self.buffer[:size]
+
+    def resync(self):
+        offset = self.buffer.find(self.marker, 1)
+        if offset == -1:
+            # Keep a possible marker prefix at the end
+            offset = max(1, len(self.buffer) - len(self.marker) + 1)
+        del self.buffer[:offset]
+
+    def finish(self, trace_hash_map: dict[str, TraceEntry]) -> Iterator[str]:
+        return iter(())
+
+
+class StreamDecoder:
+    """
+    Reads a pipe, FIFO or growing capture file in the order it arrives and writes decoded lines, output
+    is flushed no later than latency after its first pending line and whenever the input goes idle.
+    """
+
+    def __init__(self, dictionary: DictionaryWatcher, output: TextIO, latency: float, kind: str, color: bool):
+        self.dictionary = dictionary
+        self.output = output
+        self.color = color
+        self.latency = latency
+        self.kind = kind
+        self.decoder = None
+        self.head = b""
+        self.pending_since = None
+
+    def select_decoder(self, data: bytes) -> bytes:
+        if self.kind != "auto":
+            self.decoder = ArchiveDecoder(self.color) if self.kind == "archive" else TextDecoder(self.dictionary, self.color)
+            return data
+        # Wait for the magic, a short text line decides as soon as its newline arrives
+        self.head += data
+        if len(self.head) < 4 and b"\n" not in self.head:
+            return b""
+        is_archive = self.head[:4] == FILE_MAGIC.to_bytes(4, "little")
+        self.decoder = ArchiveDecoder(self.color) if is_archive else TextDecoder(self.dictionary, self.color)
+        data, self.head = self.head, b""
+        return data
+
+    def write(self, lines: Iterator[str]):
+        for line in lines:
+            self.output.write(line + "\n")
+            now = time.monotonic()
+            if self.pending_since is None:
+                self.pending_since = now
+            elif now - self.pending_since >= self.latency:
+                self.flush()
+
+    def flush(self):
+        if self.pending_since is not None:
+            self.output.flush()
+            self.pending_since = None
+
+    def feed(self, data: bytes):
+        if self.decoder is None:
+            data = self.select_decoder(data)
+            if self.decoder is None:
+                return
+        self.write(self.decoder.feed(data, self.dictionary.trace_hash_map))
+
+    def finish(self):
+        if self.decoder is None and self.head:
+            self.kind = "text"
+            self.feed(b"")
+        if self.decoder is not None:
+            self.write(self.decoder.finish(self.dictionary.trace_hash_map))
+        self.flush()
+
+    def run(self, fd: int, follow: bool):
+        while True:
+            timeout = self.latency if self.pending_since is not None else self.dictionary.interval
+            readable, _, _ = select.select([fd], [], [], timeout)
+            if self.dictionary.poll(time.monotonic()):
+                self.flush()
+                print(f"# reloaded {self.dictionary.path}", file=sys.stderr)
+            if not readable:
+                # Idle input, nothing waits longer than one select timeout
+                self.flush()
+                continue
+            data = os.read(fd, READ_SIZE)
+            if data:
+                self.feed(data)
+                continue
+            if not follow:
+                break
+            # Regular files always select readable, growing captures are polled
+            self.flush()
+            time.sleep(FOLLOW_POLL_S)
+        self.finish()
+
+
+def open_source(source: str) -> tuple[int, bool]:
+    if source == "-":
+        return sys.stdin.fileno(), False
+    path = Path(source).expanduser().resolve()
+    # Opening a FIFO blocks until the traced process opens its end
+    fd = os.open(path, os.O_RDONLY)
+    return fd, stat.S_ISREG(os.fstat(fd).st_mode)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Live decoder for text captures and trace archives")
+    parser.add_argument("source", type=str, help="Pipe, FIFO or capture file to follow, '-' for stdin")
+    parser.add_argument("csv", type=Path, help="Path to csv or tdict file, reloaded when it changes, or a directory of builds")
+    parser.add_argument("--format", type=str, choices=("auto", "text", "archive"), default="auto", help="Stream format")
+    parser.add_argument("--latency", type=float, default=DEFAULT_LATENCY_MS, help="Upper bound on output delay in milliseconds")
+    parser.add_argument("--reload-interval", type=float, default=DEFAULT_RELOAD_MS, help="Dictionary check period in milliseconds")
+    parser.add_argument("--color", type=str, choices=("auto", "always", "never"), default="auto", help="Color output, auto on terminals")
+    parser.add_argument("--no-follow", action="store_true", help="Stop at the end of a regular file instead of waiting for more")
+
+    args = parser.parse_args()
+
+    dictionary = DictionaryWatcher(args.csv.expanduser().resolve(), args.reload_interval / 1000)
+    fd, regular = open_source(args.source)
+    color = args.color == "always" or (args.color == "auto" and sys.stdout.isatty())
+    decoder = StreamDecoder(dictionary, sys.stdout, args.latency / 1000, args.format, color)
+    try:
+        decoder.run(fd, regular and not args.no_follow)
+    except KeyboardInterrupt:
+        decoder.finish()
+
+
+if __name__ == "__main__":
+    main()
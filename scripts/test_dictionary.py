@@ -0,0 +1,32 @@
+import unittest
+
+from dictionary import TraceEntry, decode_line
+
+TRACE_ID = "0123456789abcdef0123456789abcdef"
+
+
+class DecodeLineTest(unittest.TestCase):
+    def decode(self, line: str, text: str, signature: str = "") -> str:
+        return decode_line(line, {TRACE_ID: TraceEntry(text, signature)})
+
+    def test_untyped_integers_and_floats(self):
+        self.assertEqual(self.decode(f"{TRACE_ID} ff {(2.5).hex()}", "I:Values {} {}"), "I:Values 255 2.5")
+
+    def test_untyped_string_is_kept(self):
+        self.assertEqual(self.decode(f"{TRACE_ID} view 0102", "I:Text {} {}"), "I:Text view 258")
+
+    def test_typed_bools(self):
+        self.assertEqual(self.decode(f"{TRACE_ID} true false", "I:Flags {} {}", "??"), "I:Flags true false")
+
+    def test_typed_bytes(self):
+        self.assertEqual(self.decode(f"{TRACE_ID} 00ab", "I:Blob {}", "y"), "I:Blob 00ab")
+
+    def test_span_end_without_arguments(self):
+        self.assertEqual(self.decode(f"{TRACE_ID} 10 1", "F:Pastwisko {} of {:>4}"), "F:Pastwisko of ts=16 thread=1")
+
+    def test_unknown_id(self):
+        self.assertEqual(self.decode("fedcba9876543210fedcba9876543210 1", "I:Other"), "fedcba9876543210fedcba9876543210 1")
+
+
+if __name__ == "__main__":
+    unittest.main()